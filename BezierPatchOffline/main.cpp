@@ -0,0 +1,186 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  Renders a Bezier patch to an image file with no window, no Qt and
+//  no OpenGL, for batch jobs, CI and benchmarking on headless machines
+//  It drives the same software renderer as the window, so a frame drawn
+//  with the same parameters has the same pixels
+//
+///////////////////////////////////////////////////
+
+// system libraries
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+
+// local includes
+#include "../BezierPatchWindowRelease/ControlPoints.h"
+#include "../BezierPatchWindowRelease/RenderParameters.h"
+#include "../BezierPatchWindowRelease/PatchRenderer.h"
+
+// prints how to call the program
+static void printUsage(const char *program)
+    { // printUsage()
+    std::cout << "Usage: " << program << " patch.txt output.ppm [options]" << std::endl
+              << "  --size W H             resolution of the image (default 800 720)" << std::endl
+              << "  --translate X Y Z      camera translation, as the window's sliders (default 0 0 1.4)" << std::endl
+              << "  --rotate X Y Z DEGREES rotation of the patch about an axis (default none)" << std::endl
+              << "  --perspective          perspective rather than orthographic projection" << std::endl
+              << "  --resolve MODE         painters, depth, atomic or tiled (default atomic)" << std::endl
+              << "  --surface RENDERER     points, subdivision or mesh (default points)" << std::endl
+              << "  --evaluation MODE      direct, differences, table or simd (default simd)" << std::endl
+              << "  --fixed-sampling       1001 x 1001 samples rather than adaptive sampling" << std::endl
+              << "  --smooth-markers       blend the edges of the control point markers (painters resolve only)" << std::endl
+              << "  --no-surface --no-planes --no-net --no-vertices   leave that part out" << std::endl
+              << "  --frames N             render N frames, writing the last (default 1)" << std::endl
+              << "  --trace FILE           write each thread's spans of work as a Chrome trace (chrome://tracing, Perfetto)" << std::endl;
+    } // printUsage()
+
+// finds a name in a list, returning its index or -1
+static int findName(const std::string &name, const char *const names[], int nNames)
+    { // findName()
+    for (int i = 0; i < nNames; i++)
+        if (name == names[i])
+            return i;
+    return -1;
+    } // findName()
+
+// main routine
+int main(int argc, char **argv)
+    { // main()
+    // check the args to make sure there's an input and an output file
+    if (argc < 3)
+        { // bad arg count
+        printUsage(argv[0]);
+        return 1;
+        } // bad arg count
+
+    std::ifstream geometryFile(argv[1]);
+    if (!(geometryFile.good()))
+        { // object read failed
+        std::cout << "Read failed for object " << argv[1] << std::endl;
+        return 1;
+        } // object read failed
+
+    ControlPoints bezierPatch = ControlPoints::ReadPointStream(geometryFile);
+    if (bezierPatch.vertices.size() != 16)
+        { // object read failed
+        std::cout << "Read failed for control points " << argv[1] << std::endl;
+        return 1;
+        } // object read failed
+
+    // the window's default parameters, but showing the surface
+    RenderParameters renderParameters(&bezierPatch);
+    renderParameters.bezierEnabled = true;
+    int width = 800, height = 720, nFrames = 1;
+    const char *traceFileName = NULL;
+
+    const char *const resolveNames[] = { "painters", "depth", "atomic", "tiled" };
+    const char *const surfaceNames[] = { "points", "subdivision", "mesh" };
+    const char *const evaluationNames[] = { "direct", "differences", "table", "simd" };
+
+    for (int arg = 3; arg < argc; arg++)
+        { // option
+        std::string option = argv[arg];
+        // how many values follow the option
+        int nValues = option == "--size" ? 2 : option == "--translate" ? 3 : option == "--rotate" ? 4 :
+                      (option == "--resolve" || option == "--surface" || option == "--evaluation" || option == "--frames" || option == "--trace") ? 1 : 0;
+        if (arg + nValues >= argc)
+            { // missing values
+            std::cout << "Missing value for " << option << std::endl;
+            return 1;
+            } // missing values
+        char **values = argv + arg + 1;
+        arg += nValues;
+
+        int index = 0;
+        if (option == "--size")
+            { // size
+            width = atoi(values[0]);
+            height = atoi(values[1]);
+            } // size
+        else if (option == "--translate")
+            { // translate
+            renderParameters.xTranslate = (float)atof(values[0]);
+            renderParameters.yTranslate = (float)atof(values[1]);
+            renderParameters.zTranslate = (float)atof(values[2]);
+            } // translate
+        else if (option == "--rotate")
+            renderParameters.rotationMatrix.SetRotation(Vector3((float)atof(values[0]), (float)atof(values[1]), (float)atof(values[2])),
+                                                        (float)atof(values[3]) * (float)PI / 180.0f);
+        else if (option == "--perspective")
+            renderParameters.orthoProjection = false;
+        else if (option == "--resolve" && (index = findName(values[0], resolveNames, N_FRAGMENT_RESOLVE_MODES)) >= 0)
+            renderParameters.fragmentResolveMode = (FragmentResolveMode)index;
+        else if (option == "--surface" && (index = findName(values[0], surfaceNames, N_SURFACE_RENDERERS)) >= 0)
+            renderParameters.surfaceRenderer = (SurfaceRenderer)index;
+        else if (option == "--evaluation" && (index = findName(values[0], evaluationNames, N_SURFACE_EVALUATION_MODES)) >= 0)
+            renderParameters.surfaceEvaluationMode = (SurfaceEvaluationMode)index;
+        else if (option == "--fixed-sampling")
+            renderParameters.samplingPolicy = FIXED_SAMPLING;
+        else if (option == "--smooth-markers")
+            renderParameters.antialiasedMarkers = true;
+        else if (option == "--no-surface")
+            renderParameters.bezierEnabled = false;
+        else if (option == "--no-planes")
+            renderParameters.planesEnabled = false;
+        else if (option == "--no-net")
+            renderParameters.netEnabled = false;
+        else if (option == "--no-vertices")
+            renderParameters.verticesEnabled = false;
+        else if (option == "--frames")
+            nFrames = atoi(values[0]);
+        else if (option == "--trace")
+            traceFileName = values[0];
+        else
+            { // unknown option
+            std::cout << "Unknown option " << option << (nValues > 0 ? std::string(" ") + values[0] : std::string()) << std::endl;
+            printUsage(argv[0]);
+            return 1;
+            } // unknown option
+        } // option
+
+    if (width <= 0 || height <= 0 || nFrames <= 0)
+        { // bad values
+        std::cout << "The size and number of frames must be positive" << std::endl;
+        return 1;
+        } // bad values
+
+    PatchRenderer renderer(&bezierPatch, &renderParameters);
+    renderer.Resize(width, height);
+    if (traceFileName != NULL)
+        renderer.frameTracer.Start();
+
+    for (int frame = 0; frame < nFrames; frame++)
+        { // frame
+        uint64_t start = FrameTimer::Now();
+        renderer.Render();
+        uint64_t end = renderer.frameTimer.Lap(STAGE_FRAME, start);
+        renderer.frameTimer.EndFrame();
+        renderer.frameTracer.Add(FrameTimer::StageName(STAGE_FRAME), start, end);
+        std::cout << "Frame " << frame << ": " << renderer.frameTimer.Statistics(STAGE_FRAME).last << " ms\n";
+        } // frame
+    renderer.frameTimer.Report(std::cout);
+
+    if (traceFileName != NULL)
+        { // trace
+        std::ofstream traceFile(traceFileName);
+        if (!(traceFile.good()))
+            { // write failed
+            std::cout << "Write failed for trace " << traceFileName << std::endl;
+            return 1;
+            } // write failed
+        size_t nDropped = renderer.frameTracer.Dropped();
+        size_t nSpans = renderer.frameTracer.Stop(traceFile);
+        std::cout << "Wrote " << nSpans << " spans to " << traceFileName << " (" << nDropped << " more didn't fit)" << std::endl;
+        } // trace
+
+    std::ofstream imageFile(argv[2]);
+    if (!(imageFile.good()))
+        { // write failed
+        std::cout << "Write failed for image " << argv[2] << std::endl;
+        return 1;
+        } // write failed
+    renderer.frameBuffer.WritePPM(imageFile);
+    return 0;
+    } // main()
@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  A framebuffer that does its own depth test without locks
+//  Each pixel is one 64 bit atomic, with the depth in the high 32 bits
+//  and what to shade it from in the low 32 bits, so the nearest fragment
+//  is simply the smallest value and can be kept with a compare-and-swap
+//  
+///////////////////////////////////////////////////
+
+#include <string.h>
+
+#include "AtomicFrameBuffer.h"
+
+// constructor
+AtomicFrameBuffer::AtomicFrameBuffer()
+    :
+    block(nullptr),
+    width(0),
+    height(0)
+    { // AtomicFrameBuffer constructor
+    } // AtomicFrameBuffer constructor
+
+//  destructor
+AtomicFrameBuffer::~AtomicFrameBuffer()
+    { // AtomicFrameBuffer destructor
+    // release the memory
+    delete[] block;
+    } // AtomicFrameBuffer destructor
+
+// resizes the buffer, destroying any contents
+bool AtomicFrameBuffer::Resize(long Width, long Height)
+    { // Resize()
+    // check validity of dimensions
+    if ((Width < 0) || (Height < 0))
+        return false;
+
+    // release the old block (safe on nullptr)
+    delete[] block;
+
+    // the contents are set by clear() at the start of every frame
+    block = new std::atomic<uint64_t>[Width * Height];
+
+    // now that it's reallocated, reset the parameters
+    height = Height;
+    width = Width;
+
+    // done
+    return true;
+    } // Resize()
+
+// packs a depth & shade into a single value which sorts nearest first
+uint64_t AtomicFrameBuffer::pack(float depth, FragmentShade shade)
+    { // pack()
+    // Reinterpret the float so that comparing the bits as unsigned integers
+    // gives the same order as comparing the floats: positive floats only need
+    // the sign bit set, negative floats have all of their bits flipped
+    uint32_t depthBits;
+    memcpy(&depthBits, &depth, sizeof(depthBits));
+    depthBits = (depthBits & 0x80000000u) ? ~depthBits : (depthBits | 0x80000000u);
+
+    return (uint64_t(depthBits) << 32) | shade.value;
+    } // pack()
+
+// sets every pixel to the given shade at the far depth
+void AtomicFrameBuffer::clear(FragmentShade shade)
+    { // clear()
+    // all ones in the depth half is further than any float can pack to
+    uint64_t clearValue = (uint64_t(0xFFFFFFFFu) << 32) | shade.value;
+
+    long nPixels = width * height;
+    #pragma omp parallel for
+    for (long i = 0; i < nPixels; i++)
+        block[i].store(clearValue, std::memory_order_relaxed);
+    } // clear()
+
+// depth test a point in screen space and keep it if it is the nearest so far
+void AtomicFrameBuffer::depthTest(const Point3 &pixel, FragmentShade shade)
+    { // depthTest()
+    // Bounds check (also throws away the (-1, -1, -1) clipped point)
+    if (pixel.x < 0 || pixel.x >= width || pixel.y < 0 || pixel.y >= height)
+        return;
+
+    std::atomic<uint64_t> &target = block[(int)pixel.y * width + (int)pixel.x];
+    uint64_t packed = pack(pixel.z, shade);
+
+    // CAS-min: keep trying while our fragment is still nearer than what is there,
+    // a failed exchange reloads current so another thread winning just re-tests
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (packed < current && !target.compare_exchange_weak(current, packed, std::memory_order_relaxed))
+        ;
+    } // depthTest()
@@ -0,0 +1,66 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  A framebuffer that does its own depth test without locks
+//  Each pixel is one 64 bit atomic, with the depth in the high 32 bits
+//  and what to shade it from in the low 32 bits, so the nearest fragment
+//  is simply the smallest value and can be kept with a compare-and-swap
+//  
+///////////////////////////////////////////////////
+
+#ifndef ATOMICFRAMEBUFFER_H
+#define ATOMICFRAMEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "Point3.h"
+#include "FragmentShade.h"
+#include "RGBAImage.h"
+
+// the class itself
+class AtomicFrameBuffer
+    { // class AtomicFrameBuffer
+    public:
+    //  the raw data, one packed depth & shade per pixel
+    std::atomic<uint64_t> *block;
+
+    // dimensions of the buffer
+    long width, height;
+
+    // constructor
+    AtomicFrameBuffer();
+
+    // destructor
+    ~AtomicFrameBuffer();
+
+    // resizes the buffer, destroying any contents
+    bool Resize(long Width, long Height);
+
+    // sets every pixel to the given shade (usually the flat background colour) at the far depth
+    void clear(FragmentShade shade);
+
+    // depth test a point in screen space and keep it if it is the nearest so far
+    // safe to call from any number of threads at once
+    void depthTest(const Point3 &pixel, FragmentShade shade);
+
+    // colours every pixel of an image of the same size with shade(FragmentShade)
+    // from the nearest fragment kept there
+    template <typename Shader>
+    void resolve(RGBAImage &image, const Shader &shade) const;
+
+    // packs a depth & shade into a single value which sorts nearest first
+    static uint64_t pack(float depth, FragmentShade shade);
+
+    }; // class AtomicFrameBuffer
+
+// colours every pixel of an image of the same size from the nearest fragment kept there
+template <typename Shader>
+void AtomicFrameBuffer::resolve(RGBAImage &image, const Shader &shade) const
+    { // resolve()
+    long nPixels = width * height;
+    #pragma omp parallel for
+    for (long i = 0; i < nPixels; i++)
+        image.block[i] = shade(FragmentShade{ uint32_t(block[i].load(std::memory_order_relaxed)) });
+    } // resolve()
+
+#endif
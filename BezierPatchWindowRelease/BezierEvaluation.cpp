@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  Routines for evaluating cubic Bezier curves
+//  Kept free of Qt so they can be tested on their own
+//  
+///////////////////////////////////////////////////
+
+#include "BezierEvaluation.h"
+
+// Function to calculate a bezier point based on a input parameter and 4 control points
+Homogeneous4 bezierPoint(float parameter, const Homogeneous4 &controlPoint1, const Homogeneous4 &controlPoint2, const Homogeneous4 &controlPoint3, const Homogeneous4 &controlPoint4) {
+    // Precompute t coefficients for terms
+    float oneMinust = 1 - parameter;
+    float oneMinustSquared = oneMinust * oneMinust;
+    float oneMinustCubed = oneMinust * oneMinust * oneMinust;
+    float tSquared = parameter * parameter;
+    float tCubed = parameter * parameter * parameter;
+
+    // Calculate each term of the bezier for each control point
+    Homogeneous4 term1 = oneMinustCubed * controlPoint1;
+    Homogeneous4 term2 = 3 * parameter * oneMinustSquared * controlPoint2;
+    Homogeneous4 term3 = 3 * tSquared * oneMinust * controlPoint3;
+    Homogeneous4 term4 = tCubed * controlPoint4;
+
+    // Return sum of terms
+    return term1 + term2 + term3 + term4;
+}
+
+// constructor
+BezierForwardDifferencer::BezierForwardDifferencer(const Homogeneous4 &controlPoint1, const Homogeneous4 &controlPoint2, const Homogeneous4 &controlPoint3, const Homogeneous4 &controlPoint4, int nSteps, int reseedInterval)
+    :
+    controlPoints{controlPoint1, controlPoint2, controlPoint3, controlPoint4},
+    // Convert from Bernstein to power basis
+    a(3.0f * (controlPoint2 - controlPoint3) + controlPoint4 - controlPoint1),
+    b(3.0f * (controlPoint1 - 2.0f * controlPoint2 + controlPoint3)),
+    c(3.0f * (controlPoint2 - controlPoint1)),
+    d(controlPoint1),
+    stepSize(1.0f / nSteps),
+    nSteps(nSteps),
+    reseedInterval(reseedInterval > 0 ? reseedInterval : nSteps + 1),
+    currentStep(0)
+    { // constructor
+    seed(0);
+    } // constructor
+
+// recomputes the value and differences exactly at the given step
+void BezierForwardDifferencer::seed(int step)
+    { // seed()
+    // Work from the step number rather than an accumulated t so re-seeding really is exact
+    float t = (float)step / nSteps;
+    float h = stepSize;
+    float h2 = h * h;
+    float h3 = h2 * h;
+
+    // value, then the differences of the cubic between t and t + h, t + 2h, t + 3h
+    value = bezierPoint(t, controlPoints[0], controlPoints[1], controlPoints[2], controlPoints[3]);
+    delta1 = (3.0f * t * t * h + 3.0f * t * h2 + h3) * a + (2.0f * t * h + h2) * b + h * c;
+    delta2 = (6.0f * t * h2 + 6.0f * h3) * a + (2.0f * h2) * b;
+    delta3 = (6.0f * h3) * a;
+    } // seed()
+
+// returns the sample at the current step and moves on to the next
+Homogeneous4 BezierForwardDifferencer::next()
+    { // next()
+    // The last sample is always seeded so t = 1 lands exactly on the end point
+    if (currentStep != 0 && (currentStep % reseedInterval == 0 || currentStep == nSteps))
+        seed(currentStep);
+
+    Homogeneous4 sample = value;
+
+    // Three additions to move everything on by one step
+    value = value + delta1;
+    delta1 = delta1 + delta2;
+    delta2 = delta2 + delta3;
+    currentStep++;
+
+    return sample;
+    } // next()
+
+// constructor, empty until resized
+BernsteinTable::BernsteinTable()
+    :
+    nSteps(0)
+    { // constructor
+    } // constructor
+
+// rebuilds the table for a new resolution, does nothing if it is unchanged
+void BernsteinTable::Resize(int newNSteps)
+    { // Resize()
+    if (newNSteps == nSteps || newNSteps <= 0)
+        return;
+
+    nSteps = newNSteps;
+    values.resize(4 * (nSteps + 1));
+    columns.resize(4 * (nSteps + 1));
+    for (int step = 0; step <= nSteps; step++)
+        { // step
+        // work in double so every entry is correctly rounded
+        double t = (double)step / nSteps;
+        double oneMinust = 1.0 - t;
+        values[4 * step + 0] = (float)(oneMinust * oneMinust * oneMinust);
+        values[4 * step + 1] = (float)(3.0 * t * oneMinust * oneMinust);
+        values[4 * step + 2] = (float)(3.0 * t * t * oneMinust);
+        values[4 * step + 3] = (float)(t * t * t);
+
+        for (int k = 0; k < 4; k++)
+            columns[k * (nSteps + 1) + step] = values[4 * step + k];
+        } // step
+    } // Resize()
+
+// evaluates the patch at every pair of parameters in the two tables
+void evaluatePatchGrid(const Homogeneous4 controlPoints[16], const BernsteinTable &sTable, const BernsteinTable &tTable, std::vector<Homogeneous4> &grid)
+    { // evaluatePatchGrid()
+    int rowLength = tTable.nSteps + 1;
+    grid.resize((size_t)(sTable.nSteps + 1) * rowLength);
+
+    #pragma omp parallel for
+    for (int s = 0; s <= sTable.nSteps; s++)
+        { // s parameter loop
+        // the row at this s is a cubic curve in t
+        Homogeneous4 rowControlPoints[4];
+        for (int j = 0; j < 4; j++)
+            rowControlPoints[j] = bezierCombine(sTable[s], controlPoints[j], controlPoints[4 + j], controlPoints[8 + j], controlPoints[12 + j]);
+
+        Homogeneous4 *row = &grid[(size_t)s * rowLength];
+        for (int t = 0; t <= tTable.nSteps; t++)
+            row[t] = bezierCombine(tTable[t], rowControlPoints[0], rowControlPoints[1], rowControlPoints[2], rowControlPoints[3]);
+        } // s parameter loop
+    } // evaluatePatchGrid()
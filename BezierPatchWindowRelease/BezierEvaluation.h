@@ -0,0 +1,105 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  Routines for evaluating cubic Bezier curves
+//  Kept free of Qt so they can be tested on their own
+//  
+///////////////////////////////////////////////////
+
+#ifndef BEZIER_EVALUATION_H
+#define BEZIER_EVALUATION_H
+
+#include <vector>
+
+#include "Homogeneous4.h"
+
+// evaluates a cubic Bezier curve at the parameter from its 4 control points
+// using the Bernstein polynomials directly
+Homogeneous4 bezierPoint(float parameter, const Homogeneous4 &controlPoint1, const Homogeneous4 &controlPoint2, const Homogeneous4 &controlPoint3, const Homogeneous4 &controlPoint4);
+
+// combines 4 control points with precomputed Bernstein basis values
+// inline since it is called for every sample of the surface
+inline Homogeneous4 bezierCombine(const float basis[4], const Homogeneous4 &controlPoint1, const Homogeneous4 &controlPoint2, const Homogeneous4 &controlPoint3, const Homogeneous4 &controlPoint4)
+    { // bezierCombine()
+    return Homogeneous4(
+        basis[0] * controlPoint1.x + basis[1] * controlPoint2.x + basis[2] * controlPoint3.x + basis[3] * controlPoint4.x,
+        basis[0] * controlPoint1.y + basis[1] * controlPoint2.y + basis[2] * controlPoint3.y + basis[3] * controlPoint4.y,
+        basis[0] * controlPoint1.z + basis[1] * controlPoint2.z + basis[2] * controlPoint3.z + basis[3] * controlPoint4.z,
+        basis[0] * controlPoint1.w + basis[1] * controlPoint2.w + basis[2] * controlPoint3.w + basis[3] * controlPoint4.w);
+    } // bezierCombine()
+
+// a table of the 4 cubic Bernstein basis values at evenly spaced parameters
+// built once per resolution, then only read, so any number of threads can share it
+class BernsteinTable
+    { // class BernsteinTable
+    public:
+    // number of intervals between 0 and 1, so there are nSteps + 1 entries
+    int nSteps;
+
+    // the basis values, 4 per entry
+    std::vector<float> values;
+
+    // the same values as 4 separate columns (structure of arrays) for SIMD loads
+    std::vector<float> columns;
+
+    // constructor, empty until resized
+    BernsteinTable();
+
+    // rebuilds the table for a new resolution, does nothing if it is unchanged
+    void Resize(int newNSteps);
+
+    // the 4 basis values at parameter step / nSteps
+    const float * operator [](const int step) const
+        { return values.data() + 4 * step; }
+
+    // the nSteps + 1 values of basis function k (0 to 3) for every parameter
+    const float * column(const int k) const
+        { return columns.data() + k * (nSteps + 1); }
+    }; // class BernsteinTable
+
+// evaluates the patch with the given control points (row major, s down the rows) at every
+// parameter in the two tables, writing sTable.nSteps + 1 rows of tTable.nSteps + 1 points
+// to grid, each row being one value of s; rows are evaluated in parallel with OpenMP
+void evaluatePatchGrid(const Homogeneous4 controlPoints[16], const BernsteinTable &sTable, const BernsteinTable &tTable, std::vector<Homogeneous4> &grid);
+
+// steps along a cubic Bezier curve at evenly spaced parameters using third order
+// forward differences, so each step costs three vector additions instead of
+// a full evaluation of the Bernstein polynomials
+//
+// the differences are re-seeded from the polynomial every reseedInterval steps
+// so float round-off cannot build up over long runs
+// with the default interval, samples of a curve whose control points are
+// within +/-10 stay within FORWARD_DIFFERENCE_TOLERANCE of bezierPoint()
+class BezierForwardDifferencer
+    { // class BezierForwardDifferencer
+    public:
+    // constructor, nSteps is the number of intervals between t = 0 and t = 1
+    // so nSteps + 1 samples are produced
+    BezierForwardDifferencer(const Homogeneous4 &controlPoint1, const Homogeneous4 &controlPoint2, const Homogeneous4 &controlPoint3, const Homogeneous4 &controlPoint4, int nSteps, int reseedInterval = 64);
+
+    // returns the sample at the current step and moves on to the next
+    Homogeneous4 next();
+
+    private:
+    // recomputes the value and differences exactly at the given step
+    void seed(int step);
+
+    // the control points, for seeding the value exactly
+    Homogeneous4 controlPoints[4];
+
+    // the curve in power basis form: a t^3 + b t^2 + c t + d
+    Homogeneous4 a, b, c, d;
+
+    // parameter spacing, number of steps and how often to re-seed
+    float stepSize;
+    int nSteps, reseedInterval;
+
+    // the step we are on, with the value and its first, second & third differences
+    int currentStep;
+    Homogeneous4 value, delta1, delta2, delta3;
+    }; // class BezierForwardDifferencer
+
+// largest difference in any coordinate from bezierPoint() that
+// BezierForwardDifferencer is expected to make (see above)
+#define FORWARD_DIFFERENCE_TOLERANCE 1e-4f
+
+#endif
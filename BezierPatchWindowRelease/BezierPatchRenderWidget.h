@@ -18,14 +18,7 @@
 // and include all of our own headers that we need
 #include "ControlPoints.h"
 #include "RenderParameters.h"
-#include "RGBAImage.h"
-
-// Struct to hold the transformed point and colour of each 'fragment' (calculated vertex)
-// so we can sort at the end of the frame and draw each fragment in order from back to front
-struct Fragment {
-	Point3 point;
-	RGBAValue colour;
-};
+#include "PatchRenderer.h"
 
 // class for a render widget with arcball linked to an external arcball widget
 class BezierPatchRenderWidget : public QOpenGLWidget
@@ -38,35 +31,9 @@ class BezierPatchRenderWidget : public QOpenGLWidget
 	// the render parameters to use
 	RenderParameters *renderParameters;
 
-    // An image to use as a framebuffer ...
-    // ... that we will set individual pixels to
-	RGBAImage frameBuffer;
-
-	int head;
-	std::vector<Fragment> fragments;
-
-	// Projection matrix
-	Matrix4 projectionMatrix;
-	// View matrix
-	Matrix4 viewMatrix;
-	// Model matrix
-	Matrix4 modelMatrix;
-	// Model-view-projection matrix
-	Matrix4 mvpMatrix;
-
-	// Functor to compare two fragments and sort them first by x and y position and then by depth (z)
-    // So when we draw each fragment we are drawing them from back to front (Painter's algorithm)
-    struct {
-        bool operator()(const Fragment& left, const Fragment& right) const {
-            if ((int)left.point.y > (int)right.point.y) return true;
-            if ((int)left.point.y < (int)right.point.y) return false;
-            if ((int)left.point.x < (int)right.point.x) return true;
-            if ((int)left.point.x > (int)right.point.x) return false;
-            if (left.point.z > right.point.z) return true;
-            if (left.point.z < right.point.z) return false;
-            return false;
-        }
-    } lessFunctor;
+	// The software renderer, which draws each frame into its framebuffer
+	// for the widget to put on screen
+	PatchRenderer renderer;
 
 	public:
 	// constructor
@@ -83,11 +50,6 @@ class BezierPatchRenderWidget : public QOpenGLWidget
 	// destructor
     ~BezierPatchRenderWidget();
 
-	Point3 transformPoint(Homogeneous4 point);
-	Homogeneous4 bezier(float parameter, Homogeneous4 controlPoint1, Homogeneous4 controlPoint2, Homogeneous4 controlPoint3, Homogeneous4 controlPoint4);
-	void drawLine(Point3 start, Point3 end, RGBAValue colour);
-	void drawPoint(Point3 point, RGBAValue colour);
-			
 	protected:
 	// called when OpenGL context is set up
 	void initializeGL();
@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  Clipping against the six planes of the view volume in
+//  homogeneous clip space, where a point is inside when
+//  -w <= x, y, z <= w
+//  Liang-Barsky for line segments, Sutherland-Hodgman for polygons
+//  
+///////////////////////////////////////////////////
+
+#include <math.h>
+
+#include "Clipping.h"
+
+// signed distance (scaled by w) of a point inside each plane, positive inside
+static float planeDistance(const Homogeneous4 &p, int plane)
+    { // planeDistance()
+    switch (plane)
+        { // switch on plane
+        case 0: return p.w + p.x;
+        case 1: return p.w - p.x;
+        case 2: return p.w + p.y;
+        case 3: return p.w - p.y;
+        case 4: return p.w + p.z;
+        default: return p.w - p.z;
+        } // switch on plane
+    } // planeDistance()
+
+// clips the segment to the view volume with Liang-Barsky
+bool clipLine(Homogeneous4 &start, Homogeneous4 &end)
+    { // clipLine()
+    // the part of the segment kept, as parameters from start to end
+    float enter = 0.0f, leave = 1.0f;
+    for (int plane = 0; plane < 6; plane++)
+        { // plane
+        float startDistance = planeDistance(start, plane);
+        float endDistance = planeDistance(end, plane);
+        if (startDistance < 0.0f && endDistance < 0.0f)
+            return false;
+        if (startDistance < 0.0f)
+            enter = fmaxf(enter, startDistance / (startDistance - endDistance));
+        else if (endDistance < 0.0f)
+            leave = fminf(leave, startDistance / (startDistance - endDistance));
+        if (enter > leave)
+            return false;
+        } // plane
+
+    Homogeneous4 direction = end - start;
+    if (leave < 1.0f)
+        end = start + direction * leave;
+    if (enter > 0.0f)
+        start = start + direction * enter;
+    return true;
+    } // clipLine()
+
+// clips a convex polygon to the view volume with Sutherland-Hodgman
+int clipPolygon(const ClipVertex *vertices, int nVertices, ClipVertex *clipped)
+    { // clipPolygon()
+    // ping-pong between two buffers, one plane at a time
+    ClipVertex buffers[2][MAX_CLIP_VERTICES + 6];
+    const ClipVertex *in = vertices;
+    int nIn = nVertices;
+    for (int plane = 0; plane < 6; plane++)
+        { // plane
+        ClipVertex *out = plane == 5 ? clipped : buffers[plane % 2];
+        int nOut = 0;
+        for (int i = 0; i < nIn; i++)
+            { // edge from vertex i to the next
+            const ClipVertex &from = in[i], &to = in[(i + 1) % nIn];
+            float fromDistance = planeDistance(from.position, plane);
+            float toDistance = planeDistance(to.position, plane);
+            if (fromDistance >= 0.0f)
+                out[nOut++] = from;
+            if ((fromDistance >= 0.0f) != (toDistance >= 0.0f))
+                { // edge crosses the plane
+                // always interpolate from the inside end, so the polygons on either
+                // side of a shared edge get exactly the same new vertex
+                const ClipVertex &inside = fromDistance >= 0.0f ? from : to, &outside = fromDistance >= 0.0f ? to : from;
+                float insideDistance = fromDistance >= 0.0f ? fromDistance : toDistance;
+                float outsideDistance = fromDistance >= 0.0f ? toDistance : fromDistance;
+                float fraction = insideDistance / (insideDistance - outsideDistance);
+                out[nOut++] = ClipVertex{ inside.position + (outside.position - inside.position) * fraction,
+                                          inside.s + (outside.s - inside.s) * fraction,
+                                          inside.t + (outside.t - inside.t) * fraction };
+                } // edge crosses the plane
+            } // edge from vertex i to the next
+        if (nOut == 0)
+            return 0;
+        in = out;
+        nIn = nOut;
+        } // plane
+    return nIn;
+    } // clipPolygon()
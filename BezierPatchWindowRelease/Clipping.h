@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  Clipping against the six planes of the view volume in
+//  homogeneous clip space, where a point is inside when
+//  -w <= x, y, z <= w
+//  Liang-Barsky for line segments, Sutherland-Hodgman for polygons
+//  
+///////////////////////////////////////////////////
+
+#ifndef CLIPPING_H
+#define CLIPPING_H
+
+#include "Homogeneous4.h"
+
+// clipping a quad against 6 planes adds at most one vertex per plane
+#define MAX_CLIP_VERTICES 10
+
+// the point clipToViewport() returns for points outside the view volume
+inline bool isClippedPoint(const Point3 &screenPoint)
+    { return screenPoint.x == -1.0f && screenPoint.y == -1.0f && screenPoint.z == -1.0f; }
+
+// bit mask of the planes a clip space point is outside: -x, +x, -y, +y, -z, +z
+inline int outcode(const Homogeneous4 &p)
+    { return (p.x < -p.w) | (p.x > p.w) << 1 | (p.y < -p.w) << 2 | (p.y > p.w) << 3 | (p.z < -p.w) << 4 | (p.z > p.w) << 5; }
+
+// a polygon vertex with the patch parameters that go with it
+struct ClipVertex
+    { // struct ClipVertex
+    Homogeneous4 position;
+    float s, t;
+    }; // struct ClipVertex
+
+// how much geometry the clipping stage has thrown away, reset every frame
+struct ClipStatistics
+    { // struct ClipStatistics
+    // patches drawn, entirely outside, and entirely inside so drawn without clip tests
+    long patchesIn, patchesCulled, patchesInside;
+    // line segments drawn, entirely outside, and partly outside so shortened
+    long linesIn, linesCulled, linesTrimmed;
+    // surface quads drawn, entirely outside, and partly outside so clipped
+    long quadsIn, quadsCulled, quadsClipped;
+    // surface samples taken, and those outside
+    long samplesIn, samplesCulled;
+    // control point markers drawn, and those outside
+    long pointsIn, pointsCulled;
+
+    // sets every count back to zero
+    void reset()
+        { *this = ClipStatistics{}; }
+    }; // struct ClipStatistics
+
+// clips the segment from start to end to the view volume with Liang-Barsky, moving
+// either end that is outside onto the boundary
+// returns false if none of the segment is inside, in which case the ends are unchanged
+bool clipLine(Homogeneous4 &start, Homogeneous4 &end);
+
+// clips a convex polygon to the view volume with Sutherland-Hodgman, writing
+// the clipped polygon to clipped and returning how many vertices it has
+// (0 if it is entirely outside), at most nVertices + 6
+int clipPolygon(const ClipVertex *vertices, int nVertices, ClipVertex *clipped);
+
+#endif
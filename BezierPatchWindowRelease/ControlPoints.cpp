@@ -22,8 +22,42 @@ ControlPoints::ControlPoints()
     { // ControlPoints()
     // force arrays to size 0
     vertices.resize(0);
+    version = NewVersion();
+    changeLogBase = version;
     } // ControlPoints()
 
+// returns a version no patch has used yet
+unsigned long ControlPoints::NewVersion()
+    { // NewVersion()
+    static unsigned long nextVersion = 0;
+    return nextVersion++;
+    } // NewVersion()
+
+// moves one vertex by the given offset and updates the version
+void ControlPoints::MoveVertex(int index, const Vector3 &delta)
+    { // MoveVertex()
+    vertices[index] = vertices[index] + delta;
+    version = NewVersion();
+
+    changeLog.push_back(VertexChange{index, delta, version});
+    if (changeLog.size() > CONTROL_POINTS_CHANGE_LOG_LENGTH)
+        { // forget the oldest edit
+        changeLogBase = changeLog.front().version;
+        changeLog.erase(changeLog.begin());
+        } // forget the oldest edit
+    } // MoveVertex()
+
+// position in changeLog of the first edit made after the given version
+int ControlPoints::ChangesSince(unsigned long oldVersion) const
+    { // ChangesSince()
+    if (oldVersion == changeLogBase)
+        return 0;
+    for (size_t i = 0; i < changeLog.size(); i++)
+        if (changeLog[i].version == oldVersion)
+            return i + 1;
+    return -1;
+    } // ChangesSince()
+
 ControlPoints ControlPoints::ReadPointStream(std::istream &pointStream)
 {
     ControlPoints patch;
@@ -38,6 +72,8 @@ ControlPoints ControlPoints::ReadPointStream(std::istream &pointStream)
         ss >> vxCoordX >> vxCoordY >> vxCoordZ;
         patch.vertices.emplace_back(vxCoordX, vxCoordY, vxCoordZ);
     } // not eof
+    patch.version = NewVersion();
+    patch.changeLogBase = patch.version;
 
     return patch;
 }
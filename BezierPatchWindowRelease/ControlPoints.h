@@ -12,32 +12,61 @@
 // include the C++ standard libraries we need for the header
 #include <vector>
 #include <iostream>
-#ifdef __APPLE__
-#include <OpenGL/gl.h>
-#else
-#include <windows.h>
-#include <GL/gl.h>
-#endif
 
 // include the unit with Cartesian 3-vectors
 #include "Point3.h"
+#include "Vector3.h"
 
 //trying not to break includes
 class RenderParameters;
 #include "RenderParameters.h"
 
+// the number of vertex edits a patch remembers
+#define CONTROL_POINTS_CHANGE_LOG_LENGTH 64
+
+// one edit of the control points: a vertex moved by an offset, and the version it made
+struct VertexChange
+    { // struct VertexChange
+    int index;
+    Vector3 delta;
+    unsigned long version;
+    }; // struct VertexChange
+
 class ControlPoints
     { // class
     public:
     // vector of vertices
     std::vector<Point3> vertices;
 
+    // version of the vertices, changed every time they are edited so anything
+    // computed from them can tell whether it is out of date. Versions are unique
+    // across all patches, so two patches only share one if one is a copy of the other
+    unsigned long version;
+
+    // the most recent edits, oldest first, so anything computed from an older
+    // version can be brought up to date without starting again
+    std::vector<VertexChange> changeLog;
+
     // constructor will initialise to safe values
     ControlPoints();
     
     // read point cloud data routine, returns true on success, failure otherwise
     static ControlPoints ReadPointStream(std::istream &pointStream);
 
+    // moves one vertex by the given offset and updates the version
+    void MoveVertex(int index, const Vector3 &delta);
+
+    // position in changeLog of the first edit made after the given version, so the edits
+    // from there on take that version to the current one, or -1 if that is not known
+    int ChangesSince(unsigned long oldVersion) const;
+
+    private:
+    // returns a version no patch has used yet
+    static unsigned long NewVersion();
+
+    // the version before the first edit in changeLog
+    unsigned long changeLogBase;
+
     }; // class ControlPoints
 
 // end of include guard for ControlPoints
@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  A minimal class for a per-pixel depth buffer
+//  Laid out exactly like RGBAImage so the two can be indexed together
+//  
+///////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <algorithm>
+
+#include "DepthBuffer.h"
+
+// constructor
+DepthBuffer::DepthBuffer()
+    :
+    block(nullptr),
+    width(0),
+    height(0)
+    { // DepthBuffer constructor
+    } // DepthBuffer constructor
+
+//  destructor
+DepthBuffer::~DepthBuffer()
+    { // DepthBuffer destructor
+    // release the memory
+    free(block);
+    } // DepthBuffer destructor
+
+// resizes the buffer, destroying any contents
+bool DepthBuffer::Resize(long Width, long Height)
+    { // Resize()
+    // check validity of dimensions
+    if ((Width < 0) || (Height < 0))
+        return false;
+
+    // if our old block is non-null
+    if (block != nullptr)
+        // release the old pointer
+        free(block);
+
+    // no need to zero, the buffer is cleared at the start of every frame
+    block = static_cast<float *>(malloc(static_cast<unsigned long>(Height * Width) * sizeof (float)));
+    if (block == nullptr)
+        return false;
+
+    // now that it's reallocated, reset the parameters
+    height = Height;
+    width = Width;
+
+    // done
+    return true;
+    } // Resize()
+
+// depth test for a point in screen space
+bool DepthBuffer::depthTest(const Point3 &pixel)
+    { // depthTest()
+    // Bounds check (also throws away the (-1, -1, -1) clipped point)
+    if (pixel.x < 0 || pixel.x >= width || pixel.y < 0 || pixel.y >= height)
+        return false;
+
+    // Smaller z is nearer, which matches the order the Painter's algorithm draws in
+    float &depth = (*this)[(int)pixel.y][(int)pixel.x];
+    if (pixel.z >= depth)
+        return false;
+
+    depth = pixel.z;
+    return true;
+    } // depthTest()
+
+// indexing - retrieves the beginning of a line
+// array indexing will then retrieve an element
+float * DepthBuffer::operator [](const int rowIndex)
+    { // row [] index operator
+    // use pointer arithmetic to compute the row beginning
+    return block+(rowIndex*width);
+    } // [] row index operator
+
+// similar routine for const pointers
+const float * DepthBuffer::operator [](const int rowIndex) const
+    { // row [] index operator
+    // use pointer arithmetic to compute the row beginning
+    return block+(rowIndex*width);
+    } // [] row index operator
+
+// helper routine to clear
+void DepthBuffer::clear(float depth)
+    { // clear()
+    std::fill(block, block + width * height, depth);
+    } // clear()
@@ -0,0 +1,49 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  A minimal class for a per-pixel depth buffer
+//  Laid out exactly like RGBAImage so the two can be indexed together
+//  
+///////////////////////////////////////////////////
+
+#ifndef DEPTHBUFFER_H
+#define DEPTHBUFFER_H
+
+#include "Point3.h"
+
+// the class itself
+class DepthBuffer
+    { // class DepthBuffer
+    public:
+    //  the raw data, one depth value per pixel
+    float *block;
+
+    // dimensions of the buffer
+    long width, height;
+
+    // constructor
+    DepthBuffer();
+
+    // destructor
+    ~DepthBuffer();
+
+    // resizes the buffer, destroying any contents
+    bool Resize(long Width, long Height);
+
+    // depth test for a point in screen space
+    // returns true (and stores the new depth) if the point is in bounds and
+    // nearer than whatever has already been written to that pixel
+    bool depthTest(const Point3 &pixel);
+
+    // indexing - retrieves the beginning of a line
+    // array indexing will then retrieve an element
+    float * operator [](const int rowIndex);
+
+    // similar routine for const pointers
+    const float * operator [](const int rowIndex) const;
+
+    // helper routine to clear (usually to the far value)
+    void clear(float depth);
+
+    }; // class DepthBuffer
+
+#endif
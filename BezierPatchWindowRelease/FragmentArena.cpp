@@ -0,0 +1,68 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  Where the fragments of a frame are kept for the Painter's algorithm
+//  Each OpenMP thread appends to a block of its own, so any number of
+//  threads can add fragments at once without sharing a vector, and the
+//  blocks are emptied rather than freed between frames, so once they have
+//  grown to the workload a frame allocates nothing
+//
+///////////////////////////////////////////////////
+
+#include "FragmentArena.h"
+
+// constructor
+FragmentArena::FragmentArena()
+    :
+    offsets(1, 0),
+    highWaterMark(0),
+    threadHighWaterMark(0)
+    { // constructor
+    Clear();
+    } // constructor
+
+// empties every block ready for a new frame, keeping their memory
+void FragmentArena::Clear()
+    { // Clear()
+#ifdef _OPENMP
+    threadFragments.resize(omp_get_max_threads());
+#else
+    threadFragments.resize(1);
+#endif
+
+    for (std::vector<Fragment> &fragments : threadFragments)
+        fragments.clear();
+    offsets.assign(threadFragments.size() + 1, 0);
+    } // Clear()
+
+// frees every block, for when fragments stop being collected
+void FragmentArena::Release()
+    { // Release()
+    for (std::vector<Fragment> &fragments : threadFragments)
+        std::vector<Fragment>().swap(fragments);
+    offsets.assign(threadFragments.size() + 1, 0);
+    } // Release()
+
+// makes room in the calling thread's block for count more fragments
+void FragmentArena::Reserve(size_t count)
+    { // Reserve()
+    std::vector<Fragment> &fragments = currentThreadFragments();
+    size_t needed = fragments.size() + count;
+    if (needed > fragments.capacity())
+        fragments.reserve(std::max(needed, 2 * fragments.capacity()));
+    } // Reserve()
+
+// counts the blocks as one list, noting the high-water marks, and returns how many fragments there are
+size_t FragmentArena::Gather()
+    { // Gather()
+    offsets.resize(threadFragments.size() + 1);
+    size_t total = 0;
+    for (size_t thread = 0; thread < threadFragments.size(); thread++)
+        { // thread
+        offsets[thread] = total;
+        total += threadFragments[thread].size();
+        threadHighWaterMark = std::max(threadHighWaterMark, threadFragments[thread].size());
+        } // thread
+    offsets[threadFragments.size()] = total;
+    highWaterMark = std::max(highWaterMark, total);
+    return total;
+    } // Gather()
@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  Where the fragments of a frame are kept for the Painter's algorithm
+//  Each OpenMP thread appends to a block of its own, so any number of
+//  threads can add fragments at once without sharing a vector, and the
+//  blocks are emptied rather than freed between frames, so once they have
+//  grown to the workload a frame allocates nothing
+//  The blocks are counted as one list once drawing is done, and the most
+//  fragments any frame has held is kept so the blocks can be sized up front
+//
+///////////////////////////////////////////////////
+
+#ifndef FRAGMENTARENA_H
+#define FRAGMENTARENA_H
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Point3.h"
+#include "FragmentShade.h"
+
+// the transformed point of each fragment and what to shade it from, so they can be
+// sorted at the end of the frame and just the front most one at each pixel shaded
+struct Fragment
+    { // struct Fragment
+    Point3 point;
+    FragmentShade shade;
+    }; // struct Fragment
+
+// the class itself
+class FragmentArena
+    { // class FragmentArena
+    public:
+    // one block of fragments per thread, only ever added to by that thread
+    std::vector<std::vector<Fragment> > threadFragments;
+
+    // where each thread's block starts when they are counted as one list,
+    // with the total after the last, as of the last call to Gather()
+    std::vector<size_t> offsets;
+
+    // the most fragments a frame has held, in all and in any one thread's block
+    size_t highWaterMark, threadHighWaterMark;
+
+    // constructor
+    FragmentArena();
+
+    // empties every block ready for a new frame, keeping their memory
+    void Clear();
+
+    // frees every block, for when fragments stop being collected
+    void Release();
+
+    // makes room in the calling thread's block for count more fragments,
+    // growing it at least twice over so repeated calls stay cheap
+    void Reserve(size_t count);
+
+    // adds a fragment to the calling thread's block
+    inline void Add(const Fragment &fragment)
+        { // Add()
+        currentThreadFragments().push_back(fragment);
+        } // Add()
+
+    // counts the blocks as one list, noting the high-water marks, and returns how many fragments there are
+    size_t Gather();
+
+    // the fragment at an index of that list, valid until the next Clear()
+    inline const Fragment &operator [](size_t index) const
+        { // [] index operator
+        // the last block starting at or before index holds it
+        size_t thread = std::upper_bound(offsets.begin(), offsets.end() - 1, index) - offsets.begin() - 1;
+        return threadFragments[thread][index - offsets[thread]];
+        } // [] index operator
+
+    private:
+    // the block of the calling thread
+    inline std::vector<Fragment> &currentThreadFragments()
+        { // currentThreadFragments()
+#ifdef _OPENMP
+        return threadFragments[omp_get_thread_num()];
+#else
+        return threadFragments[0];
+#endif
+        } // currentThreadFragments()
+
+    }; // class FragmentArena
+
+#endif
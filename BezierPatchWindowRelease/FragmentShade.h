@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  What a fragment carries to be shaded from, in 32 bits
+//  Fragments are not coloured when they are made: most of them lose the
+//  depth test, so only the nearest at each pixel is shaded, in a pass
+//  at the end of the frame
+//
+//  A surface fragment keeps its (s, t) patch parameters, each quantized
+//  to 15 bits, and a line or marker fragment keeps its flat colour and
+//  how much of its pixel it covers, in 7 bits; the top bit tells the two apart
+//
+///////////////////////////////////////////////////
+
+#ifndef FRAGMENTSHADE_H
+#define FRAGMENTSHADE_H
+
+#include <cstdint>
+
+#include "RGBAValue.h"
+
+// steps each patch parameter is quantized to between 0 and 1
+#define SHADE_PARAMETER_MAX 32767
+// set on fragments with a flat colour
+#define SHADE_FLAT_BIT 0x80000000u
+// steps a flat fragment's coverage of its pixel is quantized to, kept above the colour
+// as the part left uncovered, so a flat fragment with no coverage given covers it all
+#define SHADE_COVERAGE_MAX 127
+#define SHADE_COVERAGE_SHIFT 24
+
+// the struct itself
+struct FragmentShade
+    { // struct FragmentShade
+    // (s, t) in the low and next 15 bits, or the red, green and blue bytes
+    uint32_t value;
+
+    // a fragment of the surface at patch parameters (s, t), clamped to 0 to 1
+    static inline FragmentShade Surface(float s, float t)
+        { // Surface()
+        s = s < 0.0f ? 0.0f : (s > 1.0f ? 1.0f : s);
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        uint32_t sBits = (uint32_t)(s * SHADE_PARAMETER_MAX + 0.5f);
+        uint32_t tBits = (uint32_t)(t * SHADE_PARAMETER_MAX + 0.5f);
+        return FragmentShade{ sBits | (tBits << 15) };
+        } // Surface()
+
+    // a fragment of a flat colour, covering all of its pixel
+    static inline FragmentShade Flat(const RGBAValue &colour)
+        { // Flat()
+        return FragmentShade{ SHADE_FLAT_BIT | (uint32_t(colour.red) << 16) | (uint32_t(colour.green) << 8) | uint32_t(colour.blue) };
+        } // Flat()
+
+    // a fragment of a flat colour covering part of its pixel, from 0 to 255
+    static inline FragmentShade Flat(const RGBAValue &colour, uint8_t coverage)
+        { // Flat()
+        uint32_t uncovered = SHADE_COVERAGE_MAX - (coverage * SHADE_COVERAGE_MAX + 127) / 255;
+        return FragmentShade{ Flat(colour).value | (uncovered << SHADE_COVERAGE_SHIFT) };
+        } // Flat()
+
+    // whether the fragment is of the surface rather than a flat colour
+    inline bool IsSurface() const
+        { // IsSurface()
+        return (value & SHADE_FLAT_BIT) == 0;
+        } // IsSurface()
+
+    // the patch parameters of a surface fragment
+    inline float S() const
+        { // S()
+        return (float)(value & SHADE_PARAMETER_MAX) / SHADE_PARAMETER_MAX;
+        } // S()
+    inline float T() const
+        { // T()
+        return (float)((value >> 15) & SHADE_PARAMETER_MAX) / SHADE_PARAMETER_MAX;
+        } // T()
+
+    // how much of its pixel the fragment covers, from 0 to 255 (all of it for the surface)
+    inline int Coverage() const
+        { // Coverage()
+        uint32_t uncovered = IsSurface() ? 0 : (value >> SHADE_COVERAGE_SHIFT) & SHADE_COVERAGE_MAX;
+        return (int)(((SHADE_COVERAGE_MAX - uncovered) * 255 + SHADE_COVERAGE_MAX / 2) / SHADE_COVERAGE_MAX);
+        } // Coverage()
+
+    // the colour of a flat fragment
+    inline RGBAValue Colour() const
+        { // Colour()
+        return RGBAValue((unsigned char)(value >> 16), (unsigned char)(value >> 8), (unsigned char)value, (unsigned char)255);
+        } // Colour()
+    }; // struct FragmentShade
+
+#endif
@@ -0,0 +1,201 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  Sorts the fragments of a frame for the Painter's algorithm
+//  Each fragment is reduced to a 64 bit key of its pixel and quantized
+//  depth, so that ordering them is ordering plain integers, and a 32 bit
+//  payload (its index) that travels with the key
+//  The keys are radix sorted: one pass on their top bits splits them into
+//  buckets small enough to stay in cache, then each bucket is sorted least
+//  significant digit first, a byte per pass, the buckets split across the
+//  OpenMP threads; the first pass takes as many of the top bits as leave
+//  whole bytes for the rest
+//
+///////////////////////////////////////////////////
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "FragmentSorter.h"
+
+// below this many fragments the sort is not worth splitting between threads
+#define PARALLEL_SORT_MIN_COUNT 65536
+
+// how many bits it takes to hold every value from 0 to maximum
+static int bitsFor(long maximum)
+    { // bitsFor()
+    int bits = 0;
+    while ((1L << bits) <= maximum)
+        bits++;
+    return bits;
+    } // bitsFor()
+
+// constructor
+FragmentSorter::FragmentSorter()
+    :
+    width(0),
+    height(0),
+    columnBits(0),
+    keyBits(FRAGMENT_DEPTH_BITS),
+    splitBits(RADIX_SPLIT_BITS),
+    count(0)
+    { // constructor
+    } // constructor
+
+// sets the screen size the keys are made for
+void FragmentSorter::Resize(long Width, long Height)
+    { // Resize()
+    width = Width;
+    height = Height;
+    // rows and columns run to one past the screen
+    columnBits = bitsFor(width);
+    keyBits = bitsFor(height) + columnBits + FRAGMENT_DEPTH_BITS;
+
+    // a few bits left over after whole digits would cost a pass of their own over every bucket,
+    // so the first pass takes them as well, as long as that leaves its buckets few enough
+    splitBits = RADIX_SPLIT_BITS + (keyBits - RADIX_SPLIT_BITS) % RADIX_BITS;
+    if (splitBits > RADIX_SPLIT_MAX_BITS)
+        splitBits = RADIX_SPLIT_BITS;
+    } // Resize()
+
+// makes room for the keys and payloads of a frame's fragments,
+// keeping the memory of earlier frames rather than reallocating it
+void FragmentSorter::Reserve(size_t Count)
+    { // Reserve()
+    count = Count;
+    if (keys.size() < count)
+        { // grow
+        keys.resize(count);
+        payloads.resize(count);
+        scratchKeys.resize(count);
+        scratchPayloads.resize(count);
+        } // grow
+    } // Reserve()
+
+// sorts the first count keys, taking their payloads with them
+void FragmentSorter::Sort()
+    { // Sort()
+    if (count < 2)
+        return;
+
+    int nThreads = 1;
+#ifdef _OPENMP
+    if (count >= PARALLEL_SORT_MIN_COUNT)
+        nThreads = omp_get_max_threads();
+#endif
+    int nSplitBuckets = 1 << splitBits;
+    threadBuckets.resize(nThreads * nSplitBuckets);
+    bucketStarts.resize(nSplitBuckets + 1);
+    int splitShift = keyBits - splitBits;
+
+    // the first pass splits the keys by their top bits into the scratch arrays, each thread
+    // scattering an equal, contiguous share of them
+    #pragma omp parallel num_threads(nThreads)
+    { // parallel region
+#ifdef _OPENMP
+    int thread = omp_get_thread_num();
+#else
+    int thread = 0;
+#endif
+    size_t first = count * thread / nThreads, last = count * (thread + 1) / nThreads;
+    size_t *buckets = &threadBuckets[thread * nSplitBuckets];
+
+    std::fill(buckets, buckets + nSplitBuckets, 0);
+    for (size_t i = first; i < last; i++)
+        buckets[keys[i] >> splitShift]++;
+    #pragma omp barrier
+
+    // turn the counts into where each thread starts writing each bucket: bucket by bucket,
+    // and within a bucket thread by thread, which keeps equal keys in the order they came
+    #pragma omp single
+    { // offsets
+    size_t offset = 0;
+    for (int bucket = 0; bucket < nSplitBuckets; bucket++)
+        { // bucket
+        bucketStarts[bucket] = offset;
+        for (int other = 0; other < nThreads; other++)
+            { // thread
+            size_t nInBucket = threadBuckets[other * nSplitBuckets + bucket];
+            threadBuckets[other * nSplitBuckets + bucket] = offset;
+            offset += nInBucket;
+            } // thread
+        } // bucket
+    bucketStarts[nSplitBuckets] = offset;
+    } // offsets
+
+    for (size_t i = first; i < last; i++)
+        { // scatter
+        size_t target = buckets[keys[i] >> splitShift]++;
+        scratchKeys[target] = keys[i];
+        scratchPayloads[target] = payloads[i];
+        } // scatter
+    } // parallel region
+
+    // then each bucket is small enough to stay in cache while the rest of the key is
+    // sorted least significant digit first, and the buckets are shared out between threads
+    int nDigits = (splitShift + RADIX_BITS - 1) / RADIX_BITS;
+    #pragma omp parallel for num_threads(nThreads) schedule(dynamic, 16)
+    for (int bucket = 0; bucket < nSplitBuckets; bucket++)
+        { // bucket
+        size_t first = bucketStarts[bucket], nInBucket = bucketStarts[bucket + 1] - first;
+        if (nInBucket == 0)
+            continue;
+
+        // each pass reads from one pair of arrays and scatters into the other
+        uint64_t *sourceKeys = &scratchKeys[first], *targetKeys = &keys[first];
+        uint32_t *sourcePayloads = &scratchPayloads[first], *targetPayloads = &payloads[first];
+
+        // count every digit in one read of the bucket (in 32 bits, as the payloads are),
+        // clearing just the counts of the digits there are, as the buckets can be small
+        uint32_t digitCounts[RADIX_MAX_DIGITS][RADIX_BUCKETS];
+        std::fill(&digitCounts[0][0], &digitCounts[0][0] + nDigits * RADIX_BUCKETS, 0);
+        for (size_t i = 0; i < nInBucket; i++)
+            for (int digit = 0; digit < nDigits; digit++)
+                digitCounts[digit][(sourceKeys[i] >> (digit * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+
+        for (int digit = 0; digit < nDigits; digit++)
+            { // digit
+            // digits every key in the bucket shares would not move anything
+            uint32_t *offsets = digitCounts[digit], offset = 0;
+            bool allInOneBucket = false;
+            for (int value = 0; value < RADIX_BUCKETS; value++)
+                { // value
+                uint32_t nWithValue = offsets[value];
+                allInOneBucket |= nWithValue == nInBucket;
+                offsets[value] = offset;
+                offset += nWithValue;
+                } // value
+            if (allInOneBucket)
+                continue;
+
+            int shift = digit * RADIX_BITS;
+            for (size_t i = 0; i < nInBucket; i++)
+                { // scatter
+                size_t target = offsets[(sourceKeys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+                targetKeys[target] = sourceKeys[i];
+                targetPayloads[target] = sourcePayloads[i];
+                } // scatter
+            std::swap(sourceKeys, targetKeys);
+            std::swap(sourcePayloads, targetPayloads);
+            } // digit
+
+        // leave the sorted bucket where it is looked for
+        if (sourceKeys != &keys[first])
+            { // copy back
+            std::copy(sourceKeys, sourceKeys + nInBucket, &keys[first]);
+            std::copy(sourcePayloads, sourcePayloads + nInBucket, &payloads[first]);
+            } // copy back
+        } // bucket
+    } // Sort()
+
+// the first sorted key at or after index that begins a row, or count if none does
+size_t FragmentSorter::RowStart(size_t index) const
+    { // RowStart()
+    if (index == 0 || index >= count)
+        return index == 0 ? 0 : count;
+    while (index < count && Row(keys[index]) == Row(keys[index - 1]))
+        index++;
+    return index;
+    } // RowStart()
@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  Sorts the fragments of a frame for the Painter's algorithm
+//  Each fragment is reduced to a 64 bit key of its pixel and quantized
+//  depth, so that ordering them is ordering plain integers, and a 32 bit
+//  payload (its index) that travels with the key
+//  The keys are radix sorted: one pass on their top bits splits them into
+//  buckets small enough to stay in cache, then each bucket is sorted least
+//  significant digit first, a byte per pass, the buckets split across the
+//  OpenMP threads; the first pass takes as many of the top bits as leave
+//  whole bytes for the rest, so no pass is spent on a few leftover bits
+//
+///////////////////////////////////////////////////
+
+#ifndef FRAGMENTSORTER_H
+#define FRAGMENTSORTER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "Point3.h"
+
+// bits of the key given to depth, which is quantized over the view volume's -1 to 1
+#define FRAGMENT_DEPTH_BITS 24
+#define FRAGMENT_DEPTH_MAX ((1u << FRAGMENT_DEPTH_BITS) - 1)
+
+// bits of the key the first pass splits the keys by: at least the fewest, and more up to the
+// most if that leaves whole digits for the passes after it
+#define RADIX_SPLIT_BITS 10
+#define RADIX_SPLIT_MAX_BITS 14
+
+// bits of the key sorted in each pass after that, the buckets that gives, and
+// the most passes the rest of a 64 bit key can take
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_MAX_DIGITS ((64 - RADIX_SPLIT_BITS + RADIX_BITS - 1) / RADIX_BITS)
+
+// the class itself
+class FragmentSorter
+    { // class FragmentSorter
+    public:
+    // dimensions of the screen the keys are made for
+    long width, height;
+
+    // how many bits of the key the column and the whole key take up, and how many the first pass splits by
+    int columnBits, keyBits, splitBits;
+
+    // how many fragments there are this frame
+    size_t count;
+
+    // the keys and payloads, in the order they were made until Sort() is called
+    // and in key order after it; sized for at least count fragments
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> payloads;
+
+    // constructor
+    FragmentSorter();
+
+    // sets the screen size the keys are made for
+    void Resize(long Width, long Height);
+
+    // makes room for the keys and payloads of a frame's fragments,
+    // keeping the memory of earlier frames rather than reallocating it
+    void Reserve(size_t Count);
+
+    // key for a fragment at a screen point, ordering fragments by rows from the
+    // top of the screen down, then columns left to right, then depth from far to near,
+    // so that the nearest fragment at each pixel comes last
+    inline uint64_t Key(const Point3 &point) const
+        { // Key()
+        // rows and columns are truncated as setPixel() does, and clamped to one past the
+        // screen, so the rare fragment just off its edge still sorts next to its neighbours
+        long column = (long)point.x, row = (long)point.y;
+        column = column < 0 ? 0 : (column > width ? width : column);
+        row = row < 0 ? 0 : (row > height ? height : row);
+
+        // depth from far (0) to near (FRAGMENT_DEPTH_MAX), rounded to the nearest step
+        float z = point.z < -1.0f ? -1.0f : (point.z > 1.0f ? 1.0f : point.z);
+        uint64_t depth = (uint64_t)((1.0f - z) * 0.5f * FRAGMENT_DEPTH_MAX + 0.5f);
+
+        uint64_t pixel = ((uint64_t)(height - row) << columnBits) | (uint64_t)column;
+        return (pixel << FRAGMENT_DEPTH_BITS) | depth;
+        } // Key()
+
+    // the pixel part of a key, equal for every fragment at the same pixel
+    static inline uint64_t Pixel(uint64_t key)
+        { // Pixel()
+        return key >> FRAGMENT_DEPTH_BITS;
+        } // Pixel()
+
+    // the row part of a key, equal for every fragment in the same row of the screen
+    inline uint64_t Row(uint64_t key) const
+        { // Row()
+        return key >> (FRAGMENT_DEPTH_BITS + columnBits);
+        } // Row()
+
+    // the first sorted key at or after index that begins a row, or count if none does,
+    // so that ranges split there give every row (and so every pixel) to just one of them
+    size_t RowStart(size_t index) const;
+
+    // sorts the first count keys, taking their payloads with them
+    // fragments with equal keys keep the order they were made in
+    void Sort();
+
+    private:
+    // the other half of each pass, kept between frames like the keys
+    std::vector<uint64_t> scratchKeys;
+    std::vector<uint32_t> scratchPayloads;
+
+    // each thread's count of keys per bucket of the first pass, then where it scatters them to
+    std::vector<size_t> threadBuckets;
+
+    // where each bucket of the first pass starts, and one past the last
+    std::vector<size_t> bucketStarts;
+
+    }; // class FragmentSorter
+
+#endif
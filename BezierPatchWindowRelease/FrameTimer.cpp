@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  How long each stage of the last few hundred frames took
+//  The thread drawing the frames times each stage as it finishes, and
+//  at the end of the frame publishes the times into a ring buffer with
+//  atomic stores, so any thread can read the rolling percentiles
+//
+///////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include "FrameTimer.h"
+
+// constructor
+FrameTimer::FrameTimer()
+    :
+    nFrames(0)
+    { // constructor
+    for (int frame = 0; frame < FRAME_TIMER_HISTORY; frame++)
+        for (int stage = 0; stage < N_FRAME_STAGES; stage++)
+            history[frame][stage].store(0, std::memory_order_relaxed);
+    BeginFrame();
+    } // constructor
+
+// the name of a stage, for reports
+const char *FrameTimer::StageName(FrameStage stage)
+    { // StageName()
+    static const char *const names[N_FRAME_STAGES] = { "clear", "matrix setup", "vertices", "planes", "net", "bezier", "sort", "resolve", "glDrawPixels", "frame" };
+    return stage >= 0 && stage < N_FRAME_STAGES ? names[stage] : "unknown";
+    } // StageName()
+
+// starts timing a new frame, with every stage at zero
+void FrameTimer::BeginFrame()
+    { // BeginFrame()
+    std::fill(pending, pending + N_FRAME_STAGES, 0);
+    } // BeginFrame()
+
+// publishes the times of the frame being timed to the ring buffer
+void FrameTimer::EndFrame()
+    { // EndFrame()
+    uint64_t frame = nFrames.load(std::memory_order_relaxed);
+    std::atomic<uint32_t> *slot = history[frame % FRAME_TIMER_HISTORY];
+    for (int stage = 0; stage < N_FRAME_STAGES; stage++)
+        slot[stage].store((uint32_t)std::min<uint64_t>(pending[stage], UINT32_MAX), std::memory_order_relaxed);
+    // readers that see the new count see the times stored before it
+    nFrames.store(frame + 1, std::memory_order_release);
+    BeginFrame();
+    } // EndFrame()
+
+// the last time and the rolling percentiles of a stage, over the frames in the ring buffer
+StageStatistics FrameTimer::Statistics(FrameStage stage) const
+    { // Statistics()
+    StageStatistics statistics = { 0.0f, 0.0f, 0.0f, 0.0f };
+    uint64_t frame = FrameCount();
+    if (frame == 0 || stage < 0 || stage >= N_FRAME_STAGES)
+        return statistics;
+
+    // leave out the oldest slot, which the next frame to be published is written into
+    size_t nSamples = (size_t)std::min<uint64_t>(frame, FRAME_TIMER_HISTORY - 1);
+    uint32_t samples[FRAME_TIMER_HISTORY];
+    for (size_t i = 0; i < nSamples; i++)
+        samples[i] = history[(frame - 1 - i) % FRAME_TIMER_HISTORY][stage].load(std::memory_order_relaxed);
+    statistics.last = samples[0] / 1.0e6f;
+
+    // nearest rank percentiles
+    std::sort(samples, samples + nSamples);
+    auto percentile = [&](size_t percent) { return samples[std::max<size_t>((percent * nSamples + 99) / 100, 1) - 1] / 1.0e6f; };
+    statistics.p50 = percentile(50);
+    statistics.p95 = percentile(95);
+    statistics.p99 = percentile(99);
+    return statistics;
+    } // Statistics()
+
+// writes a table of every stage's statistics
+void FrameTimer::Report(std::ostream &stream) const
+    { // Report()
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    uint64_t frame = FrameCount();
+    stream << "Stage times over the last " << std::min<uint64_t>(frame, FRAME_TIMER_HISTORY - 1) << " frames (ms)\n";
+    stream << std::left << std::setw(14) << "stage" << std::right << std::setw(9) << "last" << std::setw(9) << "p50"
+           << std::setw(9) << "p95" << std::setw(9) << "p99" << "\n";
+    stream << std::fixed << std::setprecision(3);
+    for (int stage = 0; stage < N_FRAME_STAGES; stage++)
+        { // stage
+        StageStatistics statistics = Statistics((FrameStage)stage);
+        stream << std::left << std::setw(14) << StageName((FrameStage)stage) << std::right << std::setw(9) << statistics.last
+               << std::setw(9) << statistics.p50 << std::setw(9) << statistics.p95 << std::setw(9) << statistics.p99 << "\n";
+        } // stage
+    stream.flags(flags);
+    stream.precision(precision);
+    } // Report()
@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  How long each stage of the last few hundred frames took
+//  The thread drawing the frames times each stage as it finishes, and
+//  at the end of the frame publishes the times into a ring buffer with
+//  atomic stores, so any thread can read the rolling median, 95th and
+//  99th percentiles of a stage without locks and without slowing the
+//  frames down
+//
+///////////////////////////////////////////////////
+
+#ifndef FRAMETIMER_H
+#define FRAMETIMER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+// number of frames kept in the ring buffer, one of which is always being overwritten
+#define FRAME_TIMER_HISTORY 256
+
+// the stages of a frame that are timed
+enum FrameStage
+    { // enum FrameStage
+    // clearing the framebuffer and depth buffers
+    STAGE_CLEAR,
+    // building the projection, view and MVP matrices
+    STAGE_MATRIX_SETUP,
+    // drawing the control point markers
+    STAGE_VERTICES,
+    // drawing the reference planes
+    STAGE_PLANES,
+    // drawing the control net
+    STAGE_NET,
+    // evaluating and rasterizing the surface
+    STAGE_BEZIER,
+    // sorting the fragments for the Painter's algorithm
+    STAGE_SORT,
+    // resolving and shading the fragments into the framebuffer
+    // (for the tiled mode, rasterizing the binned primitives too)
+    STAGE_RESOLVE,
+    // putting the framebuffer on screen
+    STAGE_DRAW_PIXELS,
+    // the whole frame, as its owner times it
+    STAGE_FRAME,
+    // number of stages
+    N_FRAME_STAGES
+    }; // enum FrameStage
+
+// the times of a stage over the frames in the ring buffer, in milliseconds
+struct StageStatistics
+    { // struct StageStatistics
+    float last, p50, p95, p99;
+    }; // struct StageStatistics
+
+// the class itself
+class FrameTimer
+    { // class FrameTimer
+    public:
+    // constructor
+    FrameTimer();
+
+    // the name of a stage, for reports
+    static const char *StageName(FrameStage stage);
+
+    // the time now, in nanoseconds from an arbitrary start
+    static inline uint64_t Now()
+        { // Now()
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        } // Now()
+
+    // starts timing a new frame, with every stage at zero
+    void BeginFrame();
+
+    // adds time to a stage of the frame being timed
+    inline void Record(FrameStage stage, uint64_t nanoseconds)
+        { // Record()
+        pending[stage] += nanoseconds;
+        } // Record()
+
+    // adds the time since start to a stage, and returns the time now to start the next stage from
+    inline uint64_t Lap(FrameStage stage, uint64_t start)
+        { // Lap()
+        uint64_t now = Now();
+        Record(stage, now - start);
+        return now;
+        } // Lap()
+
+    // publishes the times of the frame being timed to the ring buffer
+    void EndFrame();
+
+    // the number of frames published so far
+    inline uint64_t FrameCount() const
+        { // FrameCount()
+        return nFrames.load(std::memory_order_acquire);
+        } // FrameCount()
+
+    // the last time and the rolling percentiles of a stage, over the frames in the ring buffer
+    StageStatistics Statistics(FrameStage stage) const;
+
+    // writes a table of every stage's statistics
+    void Report(std::ostream &stream) const;
+
+    private:
+    // the times of the frame being timed, only touched by the thread drawing the frames
+    uint64_t pending[N_FRAME_STAGES];
+
+    // the times of the published frames in nanoseconds, frame n in slot n % FRAME_TIMER_HISTORY
+    std::atomic<uint32_t> history[FRAME_TIMER_HISTORY][N_FRAME_STAGES];
+
+    // the number of frames published, stored after each frame's times
+    std::atomic<uint64_t> nFrames;
+
+    }; // class FrameTimer
+
+#endif
@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  Spans of work by each thread while tracing, written out as Chrome
+//  trace_event JSON that chrome://tracing and the Perfetto UI can open
+//  Each thread adds its spans to a buffer of its own, allocated up front
+//  when tracing starts, so adding a span never locks or allocates
+//
+///////////////////////////////////////////////////
+
+#include <iomanip>
+
+#include "FrameTracer.h"
+
+// constructor
+FrameTracer::FrameTracer()
+    :
+    enabled(false),
+    startTime(0)
+    { // constructor
+    } // constructor
+
+// starts recording, with room for spansPerThread spans in every thread's buffer,
+// throwing away anything recorded before
+void FrameTracer::Start(size_t spansPerThread)
+    { // Start()
+#ifdef _OPENMP
+    threads.resize(omp_get_max_threads());
+#else
+    threads.resize(1);
+#endif
+
+    for (ThreadTrace &trace : threads)
+        { // thread
+        trace.spans.clear();
+        trace.spans.reserve(spansPerThread);
+        trace.nDropped = 0;
+        } // thread
+
+    startTime = FrameTimer::Now();
+    enabled = true;
+    } // Start()
+
+// stops recording and writes the spans out as trace_event JSON, returning how many were written
+size_t FrameTracer::Stop(std::ostream &stream)
+    { // Stop()
+    enabled = false;
+
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    stream << std::fixed << std::setprecision(3);
+
+    // complete ("X") events, with times in microseconds since tracing started
+    size_t nSpans = 0;
+    stream << "{\"traceEvents\":[\n";
+    for (size_t thread = 0; thread < threads.size(); thread++)
+        { // thread
+        // name each thread's track after its OpenMP thread number
+        stream << (thread == 0 ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+               << ",\"args\":{\"name\":\"OpenMP thread " << thread << "\"}}";
+        for (const TraceSpan &span : threads[thread].spans)
+            { // span
+            stream << ",\n{\"name\":\"" << span.name << "\",\"cat\":\"render\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+                   << ",\"ts\":" << (span.begin - startTime) / 1000.0 << ",\"dur\":" << (span.end - span.begin) / 1000.0 << "}";
+            nSpans++;
+            } // span
+        } // thread
+    stream << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedSpans\":" << Dropped() << "}}\n";
+
+    stream.flags(flags);
+    stream.precision(precision);
+
+    // give back the buffers
+    std::vector<ThreadTrace>().swap(threads);
+    return nSpans;
+    } // Stop()
+
+// the number of spans that didn't fit since tracing started
+size_t FrameTracer::Dropped() const
+    { // Dropped()
+    size_t nDropped = 0;
+    for (const ThreadTrace &trace : threads)
+        nDropped += trace.nDropped;
+    return nDropped;
+    } // Dropped()
@@ -0,0 +1,133 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  Spans of work by each thread while tracing, written out as Chrome
+//  trace_event JSON that chrome://tracing and the Perfetto UI can open
+//  to show how the OpenMP threads are scheduled against the serial
+//  stages of a frame
+//  Each thread adds its spans to a buffer of its own, allocated up front
+//  when tracing starts, so adding a span never locks or allocates, and
+//  spans that don't fit are counted rather than kept
+//  When tracing is off nothing is timed or stored, and each traced
+//  piece of work costs just the test of whether tracing is on
+//
+///////////////////////////////////////////////////
+
+#ifndef FRAMETRACER_H
+#define FRAMETRACER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "FrameTimer.h"
+
+// number of spans each thread has room for, unless tracing is started with another
+#define TRACE_SPANS_PER_THREAD 65536
+
+// one piece of work by one thread, in FrameTimer::Now() nanoseconds
+struct TraceSpan
+    { // struct TraceSpan
+    const char *name;
+    uint64_t begin, end;
+    }; // struct TraceSpan
+
+// the class itself
+class FrameTracer
+    { // class FrameTracer
+    public:
+    // constructor
+    FrameTracer();
+
+    // whether spans are being recorded
+    inline bool Enabled() const
+        { // Enabled()
+        return enabled;
+        } // Enabled()
+
+    // starts recording, with room for spansPerThread spans in every thread's buffer,
+    // throwing away anything recorded before
+    void Start(size_t spansPerThread = TRACE_SPANS_PER_THREAD);
+
+    // stops recording and writes the spans out as trace_event JSON, returning how many were written
+    size_t Stop(std::ostream &stream);
+
+    // adds a span by the calling thread, if tracing and there is room in its buffer
+    // the name must last until tracing stops
+    inline void Add(const char *name, uint64_t begin, uint64_t end)
+        { // Add()
+        if (!enabled)
+            return;
+        size_t thread = currentThread();
+        if (thread >= threads.size())
+            return;
+        ThreadTrace &trace = threads[thread];
+        if (trace.spans.size() < trace.spans.capacity())
+            trace.spans.push_back(TraceSpan{ name, begin, end });
+        else
+            trace.nDropped++;
+        } // Add()
+
+    // the number of spans that didn't fit since tracing started
+    size_t Dropped() const;
+
+    private:
+    // one thread's spans, each on its own cache lines so threads adding at once don't share any
+    struct alignas(64) ThreadTrace
+        { // struct ThreadTrace
+        std::vector<TraceSpan> spans;
+        size_t nDropped;
+        }; // struct ThreadTrace
+
+    // whether spans are being recorded
+    bool enabled;
+
+    // when tracing started, which the JSON times are counted from
+    uint64_t startTime;
+
+    // a buffer per OpenMP thread
+    std::vector<ThreadTrace> threads;
+
+    // the OpenMP thread number of the calling thread
+    static inline size_t currentThread()
+        { // currentThread()
+#ifdef _OPENMP
+        return (size_t)omp_get_thread_num();
+#else
+        return 0;
+#endif
+        } // currentThread()
+
+    }; // class FrameTracer
+
+// times the rest of the enclosing scope as a span of the calling thread, if tracing
+class TraceScope
+    { // class TraceScope
+    public:
+    inline TraceScope(FrameTracer &Tracer, const char *Name)
+        :
+        tracer(Tracer),
+        name(Name),
+        begin(Tracer.Enabled() ? FrameTimer::Now() : 0)
+        { // constructor
+        } // constructor
+
+    inline ~TraceScope()
+        { // destructor
+        if (begin != 0)
+            tracer.Add(name, begin, FrameTimer::Now());
+        } // destructor
+
+    private:
+    FrameTracer &tracer;
+    const char *name;
+    // when the span began, or 0 if tracing was off
+    uint64_t begin;
+
+    }; // class TraceScope
+
+#endif
@@ -0,0 +1,65 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  A precomputed round marker, stamped onto the screen around a point
+//  The pixels a disc of a given radius covers are worked out once, as a
+//  run of pixels per row, so drawing a marker is copying those runs with
+//  no per-pixel distance tests, however many markers there are
+//
+///////////////////////////////////////////////////
+
+#include "MarkerStamp.h"
+
+// constructor
+MarkerStamp::MarkerStamp()
+    :
+    radius(0),
+    nPixels(0)
+    { // constructor
+    Build(0);
+    } // constructor
+
+// works out the runs and coverage of a disc of the given radius
+void MarkerStamp::Build(int Radius)
+    { // Build()
+    radius = Radius < 0 ? 0 : Radius;
+    int size = 2 * radius + 1;
+    float discRadius = radius + 0.5f;
+
+    spanStarts.assign(size, 0);
+    spanEnds.assign(size, 0);
+    coverage.assign(size * size, 0);
+    nPixels = 0;
+
+    for (int dy = -radius; dy <= radius; dy++)
+        { // row
+        int first = radius + 1, last = -radius - 1;
+        for (int dx = -radius; dx <= radius; dx++)
+            { // pixel
+            // count the samples, spread evenly over the pixel, that lie inside the disc
+            int nInside = 0;
+            for (int sy = 0; sy < MARKER_COVERAGE_SAMPLES; sy++)
+                for (int sx = 0; sx < MARKER_COVERAGE_SAMPLES; sx++)
+                    { // sample
+                    float x = dx + (sx + 0.5f) / MARKER_COVERAGE_SAMPLES - 0.5f;
+                    float y = dy + (sy + 0.5f) / MARKER_COVERAGE_SAMPLES - 0.5f;
+                    nInside += x * x + y * y < discRadius * discRadius;
+                    } // sample
+            int nSamples = MARKER_COVERAGE_SAMPLES * MARKER_COVERAGE_SAMPLES;
+            coverage[(dy + radius) * size + dx + radius] = (uint8_t)((nInside * 255 + nSamples / 2) / nSamples);
+
+            // the disc is convex, so the pixels at least half covered are one run per row
+            if (2 * nInside >= nSamples)
+                { // covered
+                first = dx < first ? dx : first;
+                last = dx > last ? dx : last;
+                } // covered
+            } // pixel
+
+        if (first <= last)
+            { // run
+            spanStarts[dy + radius] = first;
+            spanEnds[dy + radius] = last + 1;
+            nPixels += last + 1 - first;
+            } // run
+        } // row
+    } // Build()
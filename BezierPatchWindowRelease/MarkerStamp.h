@@ -0,0 +1,55 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  A precomputed round marker, stamped onto the screen around a point
+//  The pixels a disc of a given radius covers are worked out once, as a
+//  run of pixels per row, so drawing a marker is copying those runs with
+//  no per-pixel distance tests, however many markers there are
+//  Along with the runs it keeps how much of each pixel the disc covers,
+//  as an alpha for drawing the marker anti-aliased
+//
+///////////////////////////////////////////////////
+
+#ifndef MARKERSTAMP_H
+#define MARKERSTAMP_H
+
+#include <vector>
+#include <cstdint>
+
+// samples per pixel along each axis when working out how much of it a disc covers
+#define MARKER_COVERAGE_SAMPLES 8
+
+// the class itself
+class MarkerStamp
+    { // class MarkerStamp
+    public:
+    // radius of the marker in pixels, around the pixel its point lies in
+    int radius;
+
+    // for each row from -radius to radius, the offsets from the centre pixel of the first
+    // pixel covered and one past the last (equal if the row is empty)
+    std::vector<int> spanStarts, spanEnds;
+
+    // how much of each pixel of the square from -radius to radius the disc covers, from 0
+    // to 255, a row at a time; the runs are the pixels that are at least half covered
+    std::vector<uint8_t> coverage;
+
+    // how many pixels the runs cover in all
+    long nPixels;
+
+    // constructor
+    MarkerStamp();
+
+    // works out the runs and coverage of a disc of the given radius, measured from the centre
+    // of the centre pixel to the edge of the disc, plus half a pixel so that the pixels at
+    // exactly radius along each axis are covered
+    void Build(int Radius);
+
+    // the coverage of the pixel at an offset from the centre pixel, both within the radius
+    inline uint8_t Coverage(int dx, int dy) const
+        { // Coverage()
+        return coverage[(dy + radius) * (2 * radius + 1) + dx + radius];
+        } // Coverage()
+
+    }; // class MarkerStamp
+
+#endif
@@ -0,0 +1,359 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  SIMD kernel that evaluates a row of surface samples from
+//  basis tables, clips them and maps them to the viewport
+//  Works on structure-of-arrays data, 8 samples at a time with AVX2
+//  or 4 at a time with SSE, picked at runtime from what the CPU supports
+//  
+///////////////////////////////////////////////////
+
+#include "PatchKernel.h"
+
+// SIMD paths are only built for x86 with GCC/Clang, which let us compile
+// single functions for AVX2 and ask the CPU what it supports
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PATCH_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// the best kernel level the CPU we are running on supports
+KernelLevel DetectKernelLevel()
+    { // DetectKernelLevel()
+#ifdef PATCH_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return KERNEL_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return KERNEL_SSE;
+#endif
+    return KERNEL_SCALAR;
+    } // DetectKernelLevel()
+
+// printable name of a kernel level
+const char *KernelLevelName(KernelLevel level)
+    { // KernelLevelName()
+    switch (level)
+        { // switch on level
+        case KERNEL_AVX2:
+            return "AVX2";
+        case KERNEL_SSE:
+            return "SSE";
+        default:
+            return "scalar";
+        } // switch on level
+    } // KernelLevelName()
+
+// clips a point in clip space and maps it to screen space in a viewport of the given size
+Point3 clipToViewport(const Homogeneous4 &clipPoint, float width, float height)
+    { // clipToViewport()
+    // Clipping
+    if (-clipPoint.w > clipPoint.x || clipPoint.x > clipPoint.w ||
+        -clipPoint.w > clipPoint.y || clipPoint.y > clipPoint.w ||
+        -clipPoint.w > clipPoint.z || clipPoint.z > clipPoint.w ||
+        clipPoint.w < 0.0f)
+        return Point3(-1, -1, -1); // return an invalid point so when it gets to setPixel it will be discarded
+
+    return projectToViewport(clipPoint, width, height);
+    } // clipToViewport()
+
+// maps a clip space point to screen space without clipping it
+Point3 projectToViewport(const Homogeneous4 &clipPoint, float width, float height)
+    { // projectToViewport()
+    // Perspective divide (clip space to normalised device space)
+    Point3 ndcs(clipPoint.Point());
+
+    // Viewport transformation (normalised device space to screen space)
+    float screenCoordx = (ndcs.x + 1) / 2 * width;
+    float screenCoordy = (ndcs.y + 1) / 2 * height;
+    float screenCoordz = ndcs.z; // Keep z so we can do Painter's algorithm later
+
+    return Point3(screenCoordx, screenCoordy, screenCoordz); // Return the screen point
+    } // projectToViewport()
+
+// scalar version, also used for the samples left over at the end of a SIMD row
+static void evaluatePatchRowScalar(const Homogeneous4 rowControlPoints[4], const BernsteinTable &table, int first, int last,
+                                   float width, float height, float *screenX, float *screenY, float *screenZ, bool clip)
+    { // evaluatePatchRowScalar()
+    for (int i = first; i < last; i++)
+        { // sample
+        Homogeneous4 clipPoint = bezierCombine(table[i], rowControlPoints[0], rowControlPoints[1], rowControlPoints[2], rowControlPoints[3]);
+        Point3 screenPoint = clip ? clipToViewport(clipPoint, width, height) : projectToViewport(clipPoint, width, height);
+        screenX[i] = screenPoint.x;
+        screenY[i] = screenPoint.y;
+        screenZ[i] = screenPoint.z;
+        } // sample
+    } // evaluatePatchRowScalar()
+
+#ifdef PATCH_KERNEL_X86
+
+// SSE version, 4 samples per iteration
+// the operations are done in the same order as the scalar code, and without FMA
+static int evaluatePatchRowSSE(const Homogeneous4 rowControlPoints[4], const BernsteinTable &table, int nSamples,
+                               float width, float height, float *screenX, float *screenY, float *screenZ, bool clip)
+    { // evaluatePatchRowSSE()
+    const float *b0 = table.column(0), *b1 = table.column(1), *b2 = table.column(2), *b3 = table.column(3);
+
+    // broadcast each coordinate of each control point across a register
+    __m128 px[4], py[4], pz[4], pw[4];
+    for (int k = 0; k < 4; k++)
+        { // control point
+        px[k] = _mm_set1_ps(rowControlPoints[k].x);
+        py[k] = _mm_set1_ps(rowControlPoints[k].y);
+        pz[k] = _mm_set1_ps(rowControlPoints[k].z);
+        pw[k] = _mm_set1_ps(rowControlPoints[k].w);
+        } // control point
+
+    const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps();
+    const __m128 invalid = _mm_set1_ps(-1.0f);
+    const __m128 viewportWidth = _mm_set1_ps(width), viewportHeight = _mm_set1_ps(height);
+
+    int i = 0;
+    for (; i + 4 <= nSamples; i += 4)
+        { // 4 samples
+        __m128 w0 = _mm_loadu_ps(b0 + i), w1 = _mm_loadu_ps(b1 + i), w2 = _mm_loadu_ps(b2 + i), w3 = _mm_loadu_ps(b3 + i);
+
+        // evaluate
+        __m128 x = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, px[0]), _mm_mul_ps(w1, px[1])), _mm_mul_ps(w2, px[2])), _mm_mul_ps(w3, px[3]));
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, py[0]), _mm_mul_ps(w1, py[1])), _mm_mul_ps(w2, py[2])), _mm_mul_ps(w3, py[3]));
+        __m128 z = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, pz[0]), _mm_mul_ps(w1, pz[1])), _mm_mul_ps(w2, pz[2])), _mm_mul_ps(w3, pz[3]));
+        __m128 w = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, pw[0]), _mm_mul_ps(w1, pw[1])), _mm_mul_ps(w2, pw[2])), _mm_mul_ps(w3, pw[3]));
+
+        // perspective divide and viewport
+        __m128 sx = _mm_mul_ps(_mm_div_ps(_mm_add_ps(_mm_div_ps(x, w), one), two), viewportWidth);
+        __m128 sy = _mm_mul_ps(_mm_div_ps(_mm_add_ps(_mm_div_ps(y, w), one), two), viewportHeight);
+        __m128 sz = _mm_div_ps(z, w);
+
+        if (clip)
+            { // clip
+            // keep -w <= x, y, z <= w and w >= 0
+            __m128 negW = _mm_sub_ps(zero, w);
+            __m128 inside = _mm_and_ps(_mm_cmple_ps(negW, x), _mm_cmple_ps(x, w));
+            inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmple_ps(negW, y), _mm_cmple_ps(y, w)));
+            inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmple_ps(negW, z), _mm_cmple_ps(z, w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(w, zero));
+
+            // clipped samples become (-1, -1, -1)
+            sx = _mm_or_ps(_mm_and_ps(inside, sx), _mm_andnot_ps(inside, invalid));
+            sy = _mm_or_ps(_mm_and_ps(inside, sy), _mm_andnot_ps(inside, invalid));
+            sz = _mm_or_ps(_mm_and_ps(inside, sz), _mm_andnot_ps(inside, invalid));
+            } // clip
+
+        _mm_storeu_ps(screenX + i, sx);
+        _mm_storeu_ps(screenY + i, sy);
+        _mm_storeu_ps(screenZ + i, sz);
+        } // 4 samples
+
+    return i;
+    } // evaluatePatchRowSSE()
+
+// AVX2 version, 8 samples per iteration, otherwise identical to the SSE one
+__attribute__((target("avx2")))
+static int evaluatePatchRowAVX2(const Homogeneous4 rowControlPoints[4], const BernsteinTable &table, int nSamples,
+                                float width, float height, float *screenX, float *screenY, float *screenZ, bool clip)
+    { // evaluatePatchRowAVX2()
+    const float *b0 = table.column(0), *b1 = table.column(1), *b2 = table.column(2), *b3 = table.column(3);
+
+    // broadcast each coordinate of each control point across a register
+    __m256 px[4], py[4], pz[4], pw[4];
+    for (int k = 0; k < 4; k++)
+        { // control point
+        px[k] = _mm256_set1_ps(rowControlPoints[k].x);
+        py[k] = _mm256_set1_ps(rowControlPoints[k].y);
+        pz[k] = _mm256_set1_ps(rowControlPoints[k].z);
+        pw[k] = _mm256_set1_ps(rowControlPoints[k].w);
+        } // control point
+
+    const __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f), zero = _mm256_setzero_ps();
+    const __m256 invalid = _mm256_set1_ps(-1.0f);
+    const __m256 viewportWidth = _mm256_set1_ps(width), viewportHeight = _mm256_set1_ps(height);
+
+    int i = 0;
+    for (; i + 8 <= nSamples; i += 8)
+        { // 8 samples
+        __m256 w0 = _mm256_loadu_ps(b0 + i), w1 = _mm256_loadu_ps(b1 + i), w2 = _mm256_loadu_ps(b2 + i), w3 = _mm256_loadu_ps(b3 + i);
+
+        // evaluate
+        __m256 x = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, px[0]), _mm256_mul_ps(w1, px[1])), _mm256_mul_ps(w2, px[2])), _mm256_mul_ps(w3, px[3]));
+        __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, py[0]), _mm256_mul_ps(w1, py[1])), _mm256_mul_ps(w2, py[2])), _mm256_mul_ps(w3, py[3]));
+        __m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, pz[0]), _mm256_mul_ps(w1, pz[1])), _mm256_mul_ps(w2, pz[2])), _mm256_mul_ps(w3, pz[3]));
+        __m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, pw[0]), _mm256_mul_ps(w1, pw[1])), _mm256_mul_ps(w2, pw[2])), _mm256_mul_ps(w3, pw[3]));
+
+        // perspective divide and viewport
+        __m256 sx = _mm256_mul_ps(_mm256_div_ps(_mm256_add_ps(_mm256_div_ps(x, w), one), two), viewportWidth);
+        __m256 sy = _mm256_mul_ps(_mm256_div_ps(_mm256_add_ps(_mm256_div_ps(y, w), one), two), viewportHeight);
+        __m256 sz = _mm256_div_ps(z, w);
+
+        if (clip)
+            { // clip
+            // keep -w <= x, y, z <= w and w >= 0
+            __m256 negW = _mm256_sub_ps(zero, w);
+            __m256 inside = _mm256_and_ps(_mm256_cmp_ps(negW, x, _CMP_LE_OQ), _mm256_cmp_ps(x, w, _CMP_LE_OQ));
+            inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(negW, y, _CMP_LE_OQ), _mm256_cmp_ps(y, w, _CMP_LE_OQ)));
+            inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(negW, z, _CMP_LE_OQ), _mm256_cmp_ps(z, w, _CMP_LE_OQ)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(w, zero, _CMP_GE_OQ));
+
+            // clipped samples become (-1, -1, -1)
+            sx = _mm256_blendv_ps(invalid, sx, inside);
+            sy = _mm256_blendv_ps(invalid, sy, inside);
+            sz = _mm256_blendv_ps(invalid, sz, inside);
+            } // clip
+
+        _mm256_storeu_ps(screenX + i, sx);
+        _mm256_storeu_ps(screenY + i, sy);
+        _mm256_storeu_ps(screenZ + i, sz);
+        } // 8 samples
+
+    return i;
+    } // evaluatePatchRowAVX2()
+
+// SSE version of transformSamples(), 4 samples per iteration
+static int transformSamplesSSE(const Matrix4 &matrix, const float *worldX, const float *worldY, const float *worldZ,
+                               int nSamples, float width, float height, float *screenX, float *screenY, float *screenZ, bool clip)
+    { // transformSamplesSSE()
+    // broadcast each entry of the matrix across a register
+    __m128 m[4][4];
+    for (int row = 0; row < 4; row++)
+        for (int column = 0; column < 4; column++)
+            m[row][column] = _mm_set1_ps(matrix.coordinates[row][column]);
+
+    const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps();
+    const __m128 invalid = _mm_set1_ps(-1.0f);
+    const __m128 viewportWidth = _mm_set1_ps(width), viewportHeight = _mm_set1_ps(height);
+
+    int i = 0;
+    for (; i + 4 <= nSamples; i += 4)
+        { // 4 samples
+        __m128 px = _mm_loadu_ps(worldX + i), py = _mm_loadu_ps(worldY + i), pz = _mm_loadu_ps(worldZ + i);
+
+        // transform, the point's w is 1 so the last column is added as it is
+        __m128 x = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], px), _mm_mul_ps(m[0][1], py)), _mm_mul_ps(m[0][2], pz)), m[0][3]);
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1][0], px), _mm_mul_ps(m[1][1], py)), _mm_mul_ps(m[1][2], pz)), m[1][3]);
+        __m128 z = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2][0], px), _mm_mul_ps(m[2][1], py)), _mm_mul_ps(m[2][2], pz)), m[2][3]);
+        __m128 w = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[3][0], px), _mm_mul_ps(m[3][1], py)), _mm_mul_ps(m[3][2], pz)), m[3][3]);
+
+        // perspective divide and viewport
+        __m128 sx = _mm_mul_ps(_mm_div_ps(_mm_add_ps(_mm_div_ps(x, w), one), two), viewportWidth);
+        __m128 sy = _mm_mul_ps(_mm_div_ps(_mm_add_ps(_mm_div_ps(y, w), one), two), viewportHeight);
+        __m128 sz = _mm_div_ps(z, w);
+
+        if (clip)
+            { // clip
+            // keep -w <= x, y, z <= w and w >= 0
+            __m128 negW = _mm_sub_ps(zero, w);
+            __m128 inside = _mm_and_ps(_mm_cmple_ps(negW, x), _mm_cmple_ps(x, w));
+            inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmple_ps(negW, y), _mm_cmple_ps(y, w)));
+            inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmple_ps(negW, z), _mm_cmple_ps(z, w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(w, zero));
+
+            // clipped samples become (-1, -1, -1)
+            sx = _mm_or_ps(_mm_and_ps(inside, sx), _mm_andnot_ps(inside, invalid));
+            sy = _mm_or_ps(_mm_and_ps(inside, sy), _mm_andnot_ps(inside, invalid));
+            sz = _mm_or_ps(_mm_and_ps(inside, sz), _mm_andnot_ps(inside, invalid));
+            } // clip
+
+        _mm_storeu_ps(screenX + i, sx);
+        _mm_storeu_ps(screenY + i, sy);
+        _mm_storeu_ps(screenZ + i, sz);
+        } // 4 samples
+
+    return i;
+    } // transformSamplesSSE()
+
+// AVX2 version of transformSamples(), 8 samples per iteration
+__attribute__((target("avx2")))
+static int transformSamplesAVX2(const Matrix4 &matrix, const float *worldX, const float *worldY, const float *worldZ,
+                                int nSamples, float width, float height, float *screenX, float *screenY, float *screenZ, bool clip)
+    { // transformSamplesAVX2()
+    // broadcast each entry of the matrix across a register
+    __m256 m[4][4];
+    for (int row = 0; row < 4; row++)
+        for (int column = 0; column < 4; column++)
+            m[row][column] = _mm256_set1_ps(matrix.coordinates[row][column]);
+
+    const __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f), zero = _mm256_setzero_ps();
+    const __m256 invalid = _mm256_set1_ps(-1.0f);
+    const __m256 viewportWidth = _mm256_set1_ps(width), viewportHeight = _mm256_set1_ps(height);
+
+    int i = 0;
+    for (; i + 8 <= nSamples; i += 8)
+        { // 8 samples
+        __m256 px = _mm256_loadu_ps(worldX + i), py = _mm256_loadu_ps(worldY + i), pz = _mm256_loadu_ps(worldZ + i);
+
+        // transform, the point's w is 1 so the last column is added as it is
+        __m256 x = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0][0], px), _mm256_mul_ps(m[0][1], py)), _mm256_mul_ps(m[0][2], pz)), m[0][3]);
+        __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[1][0], px), _mm256_mul_ps(m[1][1], py)), _mm256_mul_ps(m[1][2], pz)), m[1][3]);
+        __m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[2][0], px), _mm256_mul_ps(m[2][1], py)), _mm256_mul_ps(m[2][2], pz)), m[2][3]);
+        __m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[3][0], px), _mm256_mul_ps(m[3][1], py)), _mm256_mul_ps(m[3][2], pz)), m[3][3]);
+
+        // perspective divide and viewport
+        __m256 sx = _mm256_mul_ps(_mm256_div_ps(_mm256_add_ps(_mm256_div_ps(x, w), one), two), viewportWidth);
+        __m256 sy = _mm256_mul_ps(_mm256_div_ps(_mm256_add_ps(_mm256_div_ps(y, w), one), two), viewportHeight);
+        __m256 sz = _mm256_div_ps(z, w);
+
+        if (clip)
+            { // clip
+            // keep -w <= x, y, z <= w and w >= 0
+            __m256 negW = _mm256_sub_ps(zero, w);
+            __m256 inside = _mm256_and_ps(_mm256_cmp_ps(negW, x, _CMP_LE_OQ), _mm256_cmp_ps(x, w, _CMP_LE_OQ));
+            inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(negW, y, _CMP_LE_OQ), _mm256_cmp_ps(y, w, _CMP_LE_OQ)));
+            inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(negW, z, _CMP_LE_OQ), _mm256_cmp_ps(z, w, _CMP_LE_OQ)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(w, zero, _CMP_GE_OQ));
+
+            // clipped samples become (-1, -1, -1)
+            sx = _mm256_blendv_ps(invalid, sx, inside);
+            sy = _mm256_blendv_ps(invalid, sy, inside);
+            sz = _mm256_blendv_ps(invalid, sz, inside);
+            } // clip
+
+        _mm256_storeu_ps(screenX + i, sx);
+        _mm256_storeu_ps(screenY + i, sy);
+        _mm256_storeu_ps(screenZ + i, sz);
+        } // 8 samples
+
+    return i;
+    } // transformSamplesAVX2()
+
+#endif
+
+// evaluates every sample along one row of the patch
+void evaluatePatchRow(KernelLevel level, const Homogeneous4 rowControlPoints[4], const BernsteinTable &table,
+                      float width, float height, float *screenX, float *screenY, float *screenZ, bool clip)
+    { // evaluatePatchRow()
+    int nSamples = table.nSteps + 1;
+
+    // the SIMD kernels return how far they got, the scalar code finishes the row
+    int done = 0;
+#ifdef PATCH_KERNEL_X86
+    if (level == KERNEL_AVX2)
+        done = evaluatePatchRowAVX2(rowControlPoints, table, nSamples, width, height, screenX, screenY, screenZ, clip);
+    else if (level == KERNEL_SSE)
+        done = evaluatePatchRowSSE(rowControlPoints, table, nSamples, width, height, screenX, screenY, screenZ, clip);
+#else
+    (void)level;
+#endif
+    evaluatePatchRowScalar(rowControlPoints, table, done, nSamples, width, height, screenX, screenY, screenZ, clip);
+    } // evaluatePatchRow()
+
+// transforms world space samples to screen space
+void transformSamples(KernelLevel level, const Matrix4 &matrix, const float *worldX, const float *worldY, const float *worldZ,
+                      int nSamples, float width, float height, float *screenX, float *screenY, float *screenZ, bool clip)
+    { // transformSamples()
+    // the SIMD kernels return how far they got, the scalar code finishes the rest
+    int done = 0;
+#ifdef PATCH_KERNEL_X86
+    if (level == KERNEL_AVX2)
+        done = transformSamplesAVX2(matrix, worldX, worldY, worldZ, nSamples, width, height, screenX, screenY, screenZ, clip);
+    else if (level == KERNEL_SSE)
+        done = transformSamplesSSE(matrix, worldX, worldY, worldZ, nSamples, width, height, screenX, screenY, screenZ, clip);
+#else
+    (void)level;
+#endif
+    for (int i = done; i < nSamples; i++)
+        { // sample
+        Homogeneous4 clipPoint = matrix * Homogeneous4(worldX[i], worldY[i], worldZ[i]);
+        Point3 screenPoint = clip ? clipToViewport(clipPoint, width, height) : projectToViewport(clipPoint, width, height);
+        screenX[i] = screenPoint.x;
+        screenY[i] = screenPoint.y;
+        screenZ[i] = screenPoint.z;
+        } // sample
+    } // transformSamples()
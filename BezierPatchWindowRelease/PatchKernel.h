@@ -0,0 +1,57 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  SIMD kernel that evaluates a row of surface samples from
+//  basis tables, clips them and maps them to the viewport
+//  Works on structure-of-arrays data, 8 samples at a time with AVX2
+//  or 4 at a time with SSE, picked at runtime from what the CPU supports
+//  
+///////////////////////////////////////////////////
+
+#ifndef PATCH_KERNEL_H
+#define PATCH_KERNEL_H
+
+#include "Homogeneous4.h"
+#include "Point3.h"
+#include "Matrix4.h"
+#include "BezierEvaluation.h"
+
+// instruction sets the kernel can be run with
+enum KernelLevel
+    { // enum KernelLevel
+    KERNEL_SCALAR,
+    KERNEL_SSE,
+    KERNEL_AVX2
+    }; // enum KernelLevel
+
+// the best kernel level the CPU we are running on supports
+KernelLevel DetectKernelLevel();
+
+// printable name of a kernel level
+const char *KernelLevelName(KernelLevel level);
+
+// clips a point in clip space and maps it to screen space in a viewport of the given size
+// clipped points come back as (-1, -1, -1), which setPixel and the depth tests throw away
+Point3 clipToViewport(const Homogeneous4 &clipPoint, float width, float height);
+
+// maps a clip space point to screen space in a viewport of the given size without clipping it,
+// for points already known to be inside the view volume
+Point3 projectToViewport(const Homogeneous4 &clipPoint, float width, float height);
+
+// evaluates every sample along one row of the patch, given the clip space control
+// points of the row's curve in t and the basis table for the resolution, then clips
+// and maps each to screen space, writing table.nSteps + 1 values to each output array
+// the SIMD levels do the same operations in the same order as clipToViewport(bezierCombine(...)),
+// so they match it exactly unless the compiler is allowed to fuse the scalar multiply-adds
+// with clip false the clip tests are left out and every sample is projected, which is
+// only right if the whole row is known to be inside the view volume
+void evaluatePatchRow(KernelLevel level, const Homogeneous4 rowControlPoints[4], const BernsteinTable &table,
+                      float width, float height, float *screenX, float *screenY, float *screenZ, bool clip = true);
+
+// transforms nSamples world space points, given as separate x, y and z arrays, by a
+// model-view-projection matrix, then clips and maps each to screen space
+// matches clipToViewport(matrix * Homogeneous4(point)) in the same way as evaluatePatchRow,
+// and can leave out the clip tests in the same way
+void transformSamples(KernelLevel level, const Matrix4 &matrix, const float *worldX, const float *worldY, const float *worldZ,
+                      int nSamples, float width, float height, float *screenX, float *screenY, float *screenZ, bool clip = true);
+
+#endif
@@ -0,0 +1,865 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  The software renderer for the Bezier patch, with no Qt or OpenGL
+//  Sets up the camera from the render parameters, evaluates and
+//  rasterizes the patch, its control net, markers and reference planes,
+//  and resolves the fragments into a framebuffer, which the widget puts
+//  on screen and the offline renderer writes out
+//
+///////////////////////////////////////////////////
+
+#include <math.h>
+#include <algorithm>
+#include <limits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "PatchRenderer.h"
+#include "Tessellation.h"
+#include "Rasterizer.h"
+
+// Radius of the control point markers in pixels
+#define MARKER_RADIUS 5
+
+// Colour of the surface at parameters (s, t)
+static RGBAValue surfaceColour(float s, float t) {
+    return RGBAValue(255.0f * s, 255.0f / 2, 255.0f * t, 255.0f);
+}
+
+// Colour of the nearest fragment at a pixel, worked out once per pixel at the end of the frame
+static RGBAValue shadeFragment(FragmentShade shade) {
+    return shade.IsSurface() ? surfaceColour(shade.S(), shade.T()) : shade.Colour();
+}
+
+// A fragment's colour laid over the colour behind it, weighted by how much of the pixel it covers
+static RGBAValue blendFragment(const RGBAValue &behind, const RGBAValue &colour, int coverage) {
+    auto blend = [coverage](unsigned char back, unsigned char front) {
+        return (unsigned char)((front * coverage + back * (255 - coverage) + 127) / 255);
+    };
+    return RGBAValue(blend(behind.red, colour.red), blend(behind.green, colour.green), blend(behind.blue, colour.blue), (unsigned char)255);
+}
+
+// Number of threads sharing the parallel region this is called from
+static int nThreadsInRegion() {
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+// constructor
+PatchRenderer::PatchRenderer
+        (
+        // the Bezier patch control points to show
+        ControlPoints       *newPatchControlPoints,
+        // the render parameters to use
+        RenderParameters    *newRenderParameters
+        )
+    :
+    patchControlPoints(newPatchControlPoints),
+    renderParameters(newRenderParameters),
+    // ask the CPU once which SIMD instructions the surface kernel can use
+    kernelLevel(DetectKernelLevel())
+    { // constructor
+    // the control point markers are all stamped from the same disc
+    markerStamp.Build(MARKER_RADIUS);
+    } // constructor
+
+// resizes the framebuffer and everything that matches it
+void PatchRenderer::Resize(int w, int h)
+    { // PatchRenderer::Resize()
+    frameBuffer.Resize(w, h);
+    depthBuffer.Resize(w, h);
+    atomicFrameBuffer.Resize(w, h);
+    shadeBuffer.Resize(w, h);
+    tileBinner.Resize(w, h);
+    fragmentSorter.Resize(w, h);
+    } // PatchRenderer::Resize()
+
+// adds the time since start to a stage of the frame, and to the trace if tracing,
+// returning the time now to start the next stage from
+uint64_t PatchRenderer::endStage(FrameStage stage, uint64_t start)
+    { // PatchRenderer::endStage()
+    uint64_t now = frameTimer.Lap(stage, start);
+    if (frameTracer.Enabled())
+        frameTracer.Add(FrameTimer::StageName(stage), start, now);
+    return now;
+    } // PatchRenderer::endStage()
+
+// renders a frame into the framebuffer
+void PatchRenderer::Render()
+{ // PatchRenderer::Render()
+    // Time each stage as it finishes (and trace it, if tracing), the owner adds its own stages and ends the frame
+    frameTimer.BeginFrame();
+    uint64_t stageStart = FrameTimer::Now();
+
+    clipStatistics.reset();
+
+    // Fragments are only collected and sorted for the Painter's algorithm,
+    // otherwise they are depth tested straight into the framebuffer
+    FragmentResolveMode resolveMode = renderParameters->fragmentResolveMode;
+    bool paintersAlgorithm = resolveMode == PAINTERS_ALGORITHM;
+
+    // clear the (non-OpenGL) buffer where we will set pixels to:
+    // (the depth tested modes shade every pixel of it at the end of the frame instead,
+    //  from the background colour where nothing was drawn)
+    FragmentShade clearShade = FragmentShade::Flat(renderParameters->theClearColor);
+    if (resolveMode == ATOMIC_DEPTH_BUFFER)
+        atomicFrameBuffer.clear(clearShade);
+    else if (resolveMode == TILED_DEPTH_BUFFER)
+        tileBinner.Clear();
+    else if (resolveMode == DEPTH_BUFFER)
+        shadeBuffer.clear(clearShade);
+    else
+        frameBuffer.clear(renderParameters->theClearColor);
+
+    if (resolveMode == DEPTH_BUFFER)
+        depthBuffer.clear(std::numeric_limits<float>::max());
+
+    // Empty the fragment blocks, keeping the memory they grew to in earlier frames
+    if (paintersAlgorithm)
+        fragmentArena.Clear();
+    stageStart = endStage(STAGE_CLEAR, stageStart);
+
+    Matrix4 identity_matrix;
+    identity_matrix.SetIdentity();
+
+    float w = (float) frameBuffer.width;
+    float h = (float) frameBuffer.height;
+    float aspectRatio = w / h; // Calculate aspect ratio based on width and height
+
+    // Set _near and _far planes
+    float _near = 0.01f;
+    float _far = 200.0f;
+    float left, right, bottom, top;
+
+    // Projection matrix
+    projectionMatrix.SetIdentity();
+
+    // View matrix
+    viewMatrix.SetIdentity();
+
+    if (renderParameters->orthoProjection) {
+        // Set view matrix translation and rotation for orthographic projection
+        viewMatrix.SetTranslation(Vector3(renderParameters->xTranslate, renderParameters->yTranslate, renderParameters->zTranslate-1));
+        viewMatrix = viewMatrix * renderParameters->rotationMatrix;
+
+        // Set different left, right, bottom and top variables based on aspect ratio, in line with RenderWidget.cpp
+        if (aspectRatio > 1.0f) {
+            left = -aspectRatio * (10.0f / renderParameters->zTranslate);
+            right = aspectRatio * (10.0f / renderParameters->zTranslate);
+            bottom = -10.0f / renderParameters->zTranslate;
+            top = 10.0f / renderParameters->zTranslate;
+        } else {
+            left = -10.0f / renderParameters->zTranslate;
+            right = 10.0f / renderParameters->zTranslate;
+            bottom = -aspectRatio * (10.0f / renderParameters->zTranslate);
+            top = aspectRatio * (10.0f / renderParameters->zTranslate);
+        }
+
+        // glOrtho projection matrix
+        projectionMatrix[0][0] = 2.0f / (right - left);
+        projectionMatrix[1][1] = 2.0f / (top - bottom);
+        projectionMatrix[2][2] = -2.0f / (_far - _near);
+        projectionMatrix[0][3] = -(right + left) / (right - left);
+        projectionMatrix[1][3] = -(top + bottom) / (top - bottom);
+        projectionMatrix[2][3] = -(_far * _near) / (_far - _near);
+    } else {
+        // Set view matrix translation and rotation for perspective projection
+        viewMatrix.SetTranslation(Vector3(renderParameters->xTranslate, renderParameters->yTranslate, -(9.0f - renderParameters->zTranslate)));
+        viewMatrix = viewMatrix * renderParameters->rotationMatrix;
+
+        // Again, set different projection matrix parameters based on current aspect ratio
+        if (aspectRatio > 1.0f) {
+            left = -aspectRatio * 0.01f;
+            right = aspectRatio * 0.01f;
+            bottom = -0.01f;
+            top = 0.01f;
+        } else {
+            left = -0.01f;
+            right = 0.01f;
+            bottom = -aspectRatio * 0.01f;
+            top = aspectRatio * 0.01f;
+        }
+
+        // glFrustum projection matrix
+        projectionMatrix[0][0] = (2.0f * _near) / (right - left);
+        projectionMatrix[1][1] = (2.0f * _near) / (top - bottom);
+        projectionMatrix[2][2] = -(_far + _near) / (_far - _near);
+        projectionMatrix[3][3] = 0.0f;
+        projectionMatrix[0][2] = (right + left) / (right / left);
+        projectionMatrix[1][2] = (top + bottom) / (top - bottom);
+        projectionMatrix[3][2] = -1.0f;
+        projectionMatrix[2][3] = -(2.0f * _far * _near) / (_far - _near);
+    }
+
+    // Model-view-projection matrix
+    mvpMatrix.SetIdentity();
+    mvpMatrix = projectionMatrix * viewMatrix; // Combine projection and view matrix for transforming to clip space
+    stageStart = endStage(STAGE_MATRIX_SETUP, stageStart);
+
+    if(renderParameters->verticesEnabled)
+    {// UI control for showing vertices
+
+        // In the same vein as the reasoning stated for why the drawLine loops are not
+        // parallelised, is the same for this one. Since we are only iterating over 16 vertices,
+        // each of which call drawPoint which iterates over 100 pixels, only 1600 pixels
+        // are being computed, which is not in region in which the cost of invoking #pragma omp parallel for
+        // would be worth the performance gained by parallelising this loop.
+        for(int i = 0; i < (*patchControlPoints).vertices.size(); i++)
+        {
+            // draw each vertex as a point
+            // (paint the active vertex in red, ...
+            //  ... keep the others in white)
+
+            // consider ways to make the rendered points bigger than just 1x1 pixel on the screen
+            RGBAValue colour;
+            if (i == renderParameters->activeVertex) { // Set colour of active vertex to red
+                colour = RGBAValue(255.0f, 0.0f, 0.0f, 255.0f);
+            } else {                                   // keep others as an off white
+                colour = RGBAValue(255.0f * 0.75, 255.0f * 0.75, 255.0f * 0.75, 255.0f);
+            }
+
+            // Draw the vertices at the given patch control points
+            drawPoint(Point3(
+                (*patchControlPoints).vertices[(i/4)*4+(i%4)][0],
+                (*patchControlPoints).vertices[(i/4)*4+(i%4)][1],
+                (*patchControlPoints).vertices[(i/4)*4+(i%4)][2]),
+                colour);
+        }
+    }// UI control for showing vertices
+    stageStart = endStage(STAGE_VERTICES, stageStart);
+
+    if(renderParameters->planesEnabled)
+    {// UI control for showing axis-aligned planes
+        // Planes are axis aligned grids made up of lines
+
+        // The 46 lines can each cover the width of the window, so on a large window they are worth
+        // sharing between threads. Each thread adds its fragments to its own block of the fragment
+        // arena (or its own tile bins), so nothing is contended, except the plain depth buffer which
+        // has no protection against two threads testing the same pixel.
+        #pragma omp parallel if(resolveMode != DEPTH_BUFFER)
+        {
+        TraceScope threadSpan(frameTracer, "planes lines");
+        #pragma omp for nowait
+        for (int i = -5; i <= 5; i+=2) {
+            drawLine(Point3(-5, 0, i), Point3(5, 0, i), RGBAValue(255.0f / 4, 0.0f, 255.0f / 4, 255.0f)); // x plane horizontal
+            drawLine(Point3(i, 0, -5), Point3(i, 0, 5), RGBAValue(255.0f / 4, 0.0f, 255.0f / 4, 255.0f)); // x plane vertical
+            drawLine(Point3(0, i, -5), Point3(0, i, 5), RGBAValue(0.0f, 255.0f / 4, 255.0f / 4, 255.0f)); // z plane horizontal
+            drawLine(Point3(0, -5, i), Point3(0, 5, i), RGBAValue(0.0f, 255.0f / 4, 255.0f / 4, 255.0f)); // z plane vertical
+        }
+        #pragma omp for nowait
+        for (int i = -5; i <= 5; i++) {
+            drawLine(Point3(-5, i, 0), Point3(5, i, 0), RGBAValue(255.0f / 4, 255.0f / 4, 0.0f, 255.0f)); // y plane horizontal
+            drawLine(Point3(i, -5, 0), Point3(i, 5, 0), RGBAValue(255.0f / 4, 255.0f / 4, 0.0f, 255.0f)); // y plane vertical
+        }
+        }
+
+        // Refer to RenderWidget.cpp for the precise colours.
+
+    }// UI control for showing axis-aligned planes
+    stageStart = endStage(STAGE_PLANES, stageStart);
+
+    if(renderParameters->netEnabled)
+    {// UI control for showing the Bezier control net
+     // (control points connected with lines)
+
+        // The net is only 24 lines between nearby control points, too little work to be
+        // worth sharing between threads the way the planes are
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 3; j++) {
+                // Draw horizontal lines between control points
+                Point3 horzControlPoint1(                           // First control point
+                    (*patchControlPoints).vertices[i*4+j][0],
+                    (*patchControlPoints).vertices[i*4+j][1],
+                    (*patchControlPoints).vertices[i*4+j][2]);
+                Point3 horzControlPoint2(                           // Second control point
+                    (*patchControlPoints).vertices[i*4+j+1][0],
+                    (*patchControlPoints).vertices[i*4+j+1][1],
+                    (*patchControlPoints).vertices[i*4+j+1][2]);
+                
+                // Draw net line between
+                drawLine(horzControlPoint1, horzControlPoint2, RGBAValue(0.0f, 255.0f, 0.0f, 255.0f));
+
+                // Draw the vertical lines between control points
+                Point3 vertControlPoint1(                            // First control point
+                    (*patchControlPoints).vertices[i+j*4][0],
+                    (*patchControlPoints).vertices[i+j*4][1],
+                    (*patchControlPoints).vertices[i+j*4][2]);
+                Point3 vertControlPoint2(                            // Second control point
+                    (*patchControlPoints).vertices[i+4+j*4][0],
+                    (*patchControlPoints).vertices[i+4+j*4][1],
+                    (*patchControlPoints).vertices[i+4+j*4][2]);
+                
+                // Draw net line between
+                drawLine(vertControlPoint1, vertControlPoint2, RGBAValue(0.0f, 255.0f, 0.0f, 255.0f));
+            }
+        }
+
+    }// UI control for showing the Bezier control net
+    stageStart = endStage(STAGE_NET, stageStart);
+
+    if(renderParameters->bezierEnabled)
+    {// UI control for showing the Bezier curve
+        // Get the control points in a variable with shorter name for ease of reading
+        std::vector<Point3> controlPoints = renderParameters->patchControlPoints->vertices;
+
+        // Bezier patches are projectively invariant, so evaluating the patch built from the
+        // transformed control points gives the same point as transforming the evaluated point.
+        // Transform the 16 control points into clip space once, so each sample only needs
+        // the clip test and perspective divide rather than a full matrix multiply
+        Homogeneous4 clipControlPoints[16];
+        for (int i = 0; i < 16; i++)
+            clipControlPoints[i] = mvpMatrix * Homogeneous4(controlPoints[i]);
+
+        // The patch lies inside the convex hull of its control points. So if all 16 are outside
+        // one clip plane none of the patch can be seen, and if all 16 are inside all of it is
+        int outsideAll = 63, outsideAny = 0;
+        for (int i = 0; i < 16; i++) {
+            int code = outcode(clipControlPoints[i]);
+            outsideAll &= code;
+            outsideAny |= code;
+        }
+        bool needsClipping = outsideAny != 0;
+
+        clipStatistics.patchesIn++;
+        if (outsideAll != 0) {
+            clipStatistics.patchesCulled++;
+        } else {
+            if (!needsClipping)
+                clipStatistics.patchesInside++;
+
+            if (renderParameters->surfaceRenderer == RECURSIVE_SUBDIVISION)
+                drawSubdividedSurface(clipControlPoints);
+            else if (renderParameters->surfaceRenderer == TRIANGLE_MESH)
+                drawMeshSurface(clipControlPoints);
+            else
+                drawSampledSurface(clipControlPoints, needsClipping);
+        }
+    }
+    stageStart = endStage(STAGE_BEZIER, stageStart);
+
+    if (paintersAlgorithm) {
+        // Reduce every fragment to an integer key of its pixel and depth with its index as the payload,
+        // and radix sort those rather than comparing and moving the fragments themselves
+        // (the index counts every thread's block of fragments as one list)
+        long nFragments = (long)fragmentArena.Gather();
+        fragmentSorter.Reserve(nFragments);
+        #pragma omp parallel
+        {
+        TraceScope threadSpan(frameTracer, "sort keys");
+        for (size_t block = 0; block < fragmentArena.threadFragments.size(); block++) {
+            const std::vector<Fragment> &blockFragments = fragmentArena.threadFragments[block];
+            long offset = (long)fragmentArena.offsets[block], nBlockFragments = (long)blockFragments.size();
+            #pragma omp for nowait
+            for (long i = 0; i < nBlockFragments; i++) {
+                fragmentSorter.keys[offset + i] = fragmentSorter.Key(blockFragments[i].point);
+                fragmentSorter.payloads[offset + i] = (uint32_t)(offset + i);
+            }
+        }
+        }
+        fragmentSorter.Sort();
+        stageStart = endStage(STAGE_SORT, stageStart);
+
+        // Sorted by pixel, and within each pixel from back to front (Painter's algorithm)
+        const std::vector<uint64_t> &keys = fragmentSorter.keys;
+        const std::vector<uint32_t> &order = fragmentSorter.payloads;
+
+        // Each thread takes an equal share of the fragments, moved on to where rows begin so that
+        // every row, and so every pixel, is written by just one thread
+        #pragma omp parallel
+        {
+            TraceScope threadSpan(frameTracer, "painter's resolve");
+#ifdef _OPENMP
+            long thread = omp_get_thread_num(), nThreads = omp_get_num_threads();
+#else
+            long thread = 0, nThreads = 1;
+#endif
+            size_t first = fragmentSorter.RowStart(nFragments * thread / nThreads);
+            size_t last = fragmentSorter.RowStart(nFragments * (thread + 1) / nThreads);
+            for (size_t i = first; i < last; i++) {
+                // The last fragment before the pixel changes (or the fragments run out) is the front most
+                // fragment for that pixel, and the only one there that needs shading
+                if (i + 1 != (size_t)nFragments && FragmentSorter::Pixel(keys[i + 1]) == FragmentSorter::Pixel(keys[i]))
+                    continue;
+                const Fragment &front = fragmentArena[order[i]];
+                if (front.shade.Coverage() == 255) {
+                    frameBuffer.setPixel(front.point, shadeFragment(front.shade));
+                    continue;
+                }
+
+                // Unless it is the edge of an anti-aliased marker, which only covers part of the pixel.
+                // Go back to the nearest fragment behind it that covers all of the pixel (or the clear
+                // colour if none does) and blend the ones in front of that over it, back to front
+                size_t back = i;
+                while (back > first && FragmentSorter::Pixel(keys[back - 1]) == FragmentSorter::Pixel(keys[i])
+                       && fragmentArena[order[back]].shade.Coverage() != 255)
+                    back--;
+                RGBAValue colour = frameBuffer[(int)front.point.y][(int)front.point.x];
+                for (size_t j = back; j <= i; j++) {
+                    FragmentShade shade = fragmentArena[order[j]].shade;
+                    colour = blendFragment(colour, shadeFragment(shade), shade.Coverage());
+                }
+                frameBuffer.setPixel(front.point, colour);
+            }
+        }
+    } else if (fragmentArena.offsets.back() != 0) {
+        // Give back the memory from the last Painter's algorithm frame
+        fragmentArena.Release();
+    }
+
+    // The nearest fragments are already resolved, shade just those
+    auto shade = [](FragmentShade fragmentShade) { return shadeFragment(fragmentShade); };
+    if (resolveMode == DEPTH_BUFFER)
+        shadeBuffer.resolve(frameBuffer, shade);
+    if (resolveMode == ATOMIC_DEPTH_BUFFER)
+        atomicFrameBuffer.resolve(frameBuffer, shade);
+
+    // Everything drawn this frame is waiting in the tile bins, rasterize and shade it a tile per thread
+    if (resolveMode == TILED_DEPTH_BUFFER)
+        tileBinner.Resolve(kernelLevel, frameBuffer, depthBuffer, clearShade, shade);
+    endStage(STAGE_RESOLVE, stageStart);
+
+} // PatchRenderer::Render()
+
+// Function to draw the surface by sampling it on a grid in (s, t) and writing each sample
+// as a fragment. Takes the control points already transformed to clip space.
+// If needsClipping is false the whole patch is known to be inside the view volume, so
+// the samples are projected without being tested against it.
+void PatchRenderer::drawSampledSurface(const Homogeneous4 clipControlPoints[16], bool needsClipping) {
+    FragmentResolveMode resolveMode = renderParameters->fragmentResolveMode;
+    bool paintersAlgorithm = resolveMode == PAINTERS_ALGORITHM;
+
+    // Number of intervals the patch is sampled at in each of s and t. The adaptive policy
+    // picks them from how fast the patch's curves can move across the screen as s and t
+    // change, so neighbouring samples are close enough to leave no holes without a fixed
+    // million samples of overdraw
+    int nStepsS = 1000, nStepsT = 1000;
+    float speedS, speedT;
+    if (renderParameters->samplingPolicy == ADAPTIVE_SAMPLING) {
+        if (projectedNetSpeeds(clipControlPoints, frameBuffer.width, frameBuffer.height, speedS, speedT)) {
+            nStepsS = samplingSteps(speedS, renderParameters->samplesPerPixel);
+            nStepsT = samplingSteps(speedT, renderParameters->samplesPerPixel);
+        } else {
+            // Part of the net is behind the camera, so its size on screen is unbounded
+            nStepsS = nStepsT = MAX_SAMPLE_STEPS;
+        }
+    }
+
+    if (renderParameters->cacheTessellation) {
+        drawCachedSurface(nStepsS, nStepsT, needsClipping);
+        return;
+    }
+
+    int nSamplesPerRow = nStepsT + 1;
+
+    // The Bernstein basis values for each sample are the same every row and every frame,
+    // so they are only rebuilt when the resolution changes and are shared by every thread
+    sBasisTable.Resize(nStepsS);
+    tBasisTable.Resize(nStepsT);
+
+    int nSamples = (nStepsS + 1) * nSamplesPerRow;
+
+    SurfaceEvaluationMode evaluationMode = renderParameters->surfaceEvaluationMode;
+    long samplesCulled = 0;
+
+    // The plain depth buffer has no protection against two threads testing the same pixel
+    // at once, so when it is in use the samples are evaluated and written serially.
+    // Each thread owns its own block of the fragment arena and its own tile bins, and the
+    // atomic framebuffer is lock-free.
+    #pragma omp parallel if(resolveMode != DEPTH_BUFFER)
+    { // parallel region
+    TraceScope threadSpan(frameTracer, "bezier rows");
+
+    // The rows are shared out evenly, so make room for this thread's share of the samples up front
+    if (paintersAlgorithm)
+        fragmentArena.Reserve(nSamples / nThreadsInRegion() + nSamplesPerRow);
+
+    // Each thread keeps its own row of screen space samples for the SIMD kernel to fill
+    std::vector<float> rowX, rowY, rowZ;
+    if (evaluationMode == SIMD_KERNEL) {
+        rowX.resize(nSamplesPerRow);
+        rowY.resize(nSamplesPerRow);
+        rowZ.resize(nSamplesPerRow);
+    }
+    // and its own row of clip space samples for the forward differences to fill
+    std::vector<Homogeneous4> rowPoints;
+    if (evaluationMode == FORWARD_DIFFERENCES)
+        rowPoints.resize(nSamplesPerRow);
+
+    // No barrier at the end of the rows, the one at the end of the region is enough
+    #pragma omp for reduction(+:samplesCulled) nowait
+    for (int s = 0; s <= nStepsS; s++) // for loop parameter needs to be int for omp (remember to float cast and divide later)
+    {// s parameter loop
+        float sParameter = (float)s / nStepsS;
+
+        // For a fixed s the row of samples is itself a cubic Bezier curve in t, whose control
+        // points are the columns of the control net combined with the basis values at s
+        const float *basisS = sBasisTable[s];
+        Homogeneous4 rowControlPoints[4];
+        for (int j = 0; j < 4; j++)
+            rowControlPoints[j] = bezierCombine(basisS, clipControlPoints[j], clipControlPoints[4 + j], clipControlPoints[8 + j], clipControlPoints[12 + j]);
+
+        // Evaluate, clip and project the whole row at once, 8 or 4 samples per instruction
+        if (evaluationMode == SIMD_KERNEL)
+            evaluatePatchRow(kernelLevel, rowControlPoints, tBasisTable, frameBuffer.width, frameBuffer.height, rowX.data(), rowY.data(), rowZ.data(), needsClipping);
+
+        // Step along it with forward differences, seeded fresh for every row so round-off never carries between rows
+        if (evaluationMode == FORWARD_DIFFERENCES) {
+            BezierForwardDifferencer rowCurve(rowControlPoints[0], rowControlPoints[1], rowControlPoints[2], rowControlPoints[3], nStepsT);
+            for (int tIndex = 0; tIndex <= nStepsT; tIndex++)
+                rowPoints[tIndex] = rowCurve.next();
+        }
+
+        // t is stepped as an integer so every row has exactly nStepsT + 1 samples at exactly i / nStepsT
+        for (int tIndex = 0; tIndex <= nStepsT; tIndex++)
+        { // t parameter loop
+        float t = (float)tIndex / nStepsT;
+
+        Point3 screenPoint;
+        if (evaluationMode == SIMD_KERNEL) {
+            screenPoint = Point3(rowX[tIndex], rowY[tIndex], rowZ[tIndex]);
+        } else {
+            Homogeneous4 finalPoint;
+            if (evaluationMode == BASIS_TABLE) {
+                // Contract the row with the basis values at t, 16 multiply-adds per sample
+                finalPoint = bezierCombine(tBasisTable[tIndex], rowControlPoints[0], rowControlPoints[1], rowControlPoints[2], rowControlPoints[3]);
+            } else if (evaluationMode == FORWARD_DIFFERENCES) {
+                finalPoint = rowPoints[tIndex];
+            } else {
+                // Find clip space coordinates from each bezier curve at t parameter
+                Homogeneous4 bezier1 = bezier(t, clipControlPoints[0], clipControlPoints[1], clipControlPoints[2], clipControlPoints[3]);
+                Homogeneous4 bezier2 = bezier(t, clipControlPoints[4], clipControlPoints[5], clipControlPoints[6], clipControlPoints[7]);
+                Homogeneous4 bezier3 = bezier(t, clipControlPoints[8], clipControlPoints[9], clipControlPoints[10], clipControlPoints[11]);
+                Homogeneous4 bezier4 = bezier(t, clipControlPoints[12], clipControlPoints[13], clipControlPoints[14], clipControlPoints[15]);
+
+                // Find final point using the previous 4 points as points for a final bezier curve with s parameter
+                finalPoint = bezier(sParameter, bezier1, bezier2, bezier3, bezier4);
+            }
+
+            // Clip and project the point to screen space (it is already in clip space)
+            screenPoint = needsClipping ? clipToScreen(finalPoint) : projectToViewport(finalPoint, frameBuffer.width, frameBuffer.height);
+        }
+
+        bool clipped = needsClipping && isClippedPoint(screenPoint);
+        samplesCulled += clipped;
+
+        if (!clipped)
+            writeFragment(screenPoint, FragmentShade::Surface(sParameter, t));
+
+        } // t parameter loop
+    } // s parameter loop
+    } // parallel region
+
+    clipStatistics.samplesIn += nSamples;
+    clipStatistics.samplesCulled += samplesCulled;
+}
+
+// Draws the surface from world space samples kept between frames, so while the control net
+// is unchanged each frame only transforms the samples and writes their fragments
+void PatchRenderer::drawCachedSurface(int nStepsS, int nStepsT, bool needsClipping) {
+    FragmentResolveMode resolveMode = renderParameters->fragmentResolveMode;
+    bool paintersAlgorithm = resolveMode == PAINTERS_ALGORITHM;
+    ControlPoints *controlPoints = renderParameters->patchControlPoints;
+
+    // If the net has only had a few vertices nudged since the samples were taken,
+    // move the samples by how much each nudge moves the surface instead
+    int firstChange = controlPoints->ChangesSince(surfaceCache.version);
+    if (surfaceCache.version != controlPoints->version && firstChange >= 0 &&
+        surfaceCache.Updatable() && surfaceCache.Covers(nStepsS, nStepsT)) {
+        // Add up every change first so the samples get a single pass
+        Vector3 deltas[16];
+        for (size_t i = firstChange; i < controlPoints->changeLog.size(); i++)
+            deltas[controlPoints->changeLog[i].index] = deltas[controlPoints->changeLog[i].index] + controlPoints->changeLog[i].delta;
+        surfaceCache.ApplyChanges(deltas, controlPoints->version);
+    }
+
+    if (!surfaceCache.Fits(controlPoints->version, nStepsS, nStepsT)) {
+        // The adaptive resolution changes a little with every camera move, so build
+        // with some to spare and the cache lasts until the patch grows a quarter bigger
+        if (renderParameters->samplingPolicy == ADAPTIVE_SAMPLING) {
+            nStepsS = std::min(MAX_SAMPLE_STEPS, nStepsS + nStepsS / 4);
+            nStepsT = std::min(MAX_SAMPLE_STEPS, nStepsT + nStepsT / 4);
+        }
+        surfaceCache.Build(controlPoints->vertices, controlPoints->version, nStepsS, nStepsT);
+    }
+    int nRows = surfaceCache.nStepsS + 1;
+    int nSamplesPerRow = surfaceCache.rowLength();
+
+    long samplesCulled = 0;
+
+    // Same threading as drawSampledSurface()
+    #pragma omp parallel if(resolveMode != DEPTH_BUFFER)
+    { // parallel region
+    TraceScope threadSpan(frameTracer, "bezier cached rows");
+    std::vector<float> rowX(nSamplesPerRow), rowY(nSamplesPerRow), rowZ(nSamplesPerRow);
+    if (paintersAlgorithm)
+        fragmentArena.Reserve(nRows * nSamplesPerRow / nThreadsInRegion() + nSamplesPerRow);
+
+    #pragma omp for reduction(+:samplesCulled) nowait
+    for (int s = 0; s < nRows; s++)
+    { // row loop
+        int rowStart = s * nSamplesPerRow;
+
+        // Transform, clip and project the whole row at once
+        transformSamples(kernelLevel, mvpMatrix, &surfaceCache.x[rowStart], &surfaceCache.y[rowStart], &surfaceCache.z[rowStart],
+                         nSamplesPerRow, frameBuffer.width, frameBuffer.height, rowX.data(), rowY.data(), rowZ.data(), needsClipping);
+
+        for (int t = 0; t < nSamplesPerRow; t++)
+        { // sample loop
+        Point3 screenPoint(rowX[t], rowY[t], rowZ[t]);
+        bool clipped = needsClipping && isClippedPoint(screenPoint);
+        samplesCulled += clipped;
+
+        if (!clipped)
+            writeFragment(screenPoint, surfaceCache.shades[rowStart + t]);
+        } // sample loop
+    } // row loop
+    } // parallel region
+
+    clipStatistics.samplesIn += (long)nRows * nSamplesPerRow;
+    clipStatistics.samplesCulled += samplesCulled;
+}
+
+// Function to draw the surface by recursively subdividing it until each piece is flat on screen,
+// then filling each piece as a pair of triangles. The work done depends on how curved the patch
+// looks, not on a fixed number of samples. Takes the control points already in clip space.
+void PatchRenderer::drawSubdividedSurface(const Homogeneous4 clipControlPoints[16]) {
+    // The subdivision spreads itself over the cores with OpenMP tasks
+    subdividePatch(clipControlPoints, frameBuffer.width, frameBuffer.height, renderParameters->subdivisionFlatness, patchLeaves);
+
+    long quadsCulled = 0, quadsClipped = 0;
+
+    // Every resolve mode but the plain depth buffer can take fragments from several threads at once
+    FragmentResolveMode resolveMode = renderParameters->fragmentResolveMode;
+    #pragma omp parallel if(resolveMode != DEPTH_BUFFER)
+    {
+    TraceScope threadSpan(frameTracer, "bezier subdivided quads");
+    #pragma omp for schedule(dynamic, 64) reduction(+:quadsCulled, quadsClipped) nowait
+    for (int i = 0; i < (int)patchLeaves.size(); i++) {
+        const PatchLeaf &leaf = patchLeaves[i];
+        QuadClipResult result = drawSurfaceQuad(leaf.corners, leaf.s0, leaf.s1, leaf.t0, leaf.t1);
+        quadsCulled += result == QUAD_CULLED;
+        quadsClipped += result == QUAD_CLIPPED;
+    }
+    }
+
+    clipStatistics.quadsIn += patchLeaves.size();
+    clipStatistics.quadsCulled += quadsCulled;
+    clipStatistics.quadsClipped += quadsClipped;
+}
+
+// Function to transform a point from world space to clip space, and to do the necessary clipping check
+// so vertices that are behind the camera don't reappear back in front of it.
+Point3 PatchRenderer::transformPoint(Homogeneous4 point) {
+    // Transform the point from world space to clip space, then on to screen space
+    return clipToScreen(mvpMatrix * point);
+}
+
+// Function to clip a point already in clip space, then do the perspective divide and
+// viewport transformation. Since the clip test is done on the clip space point itself,
+// it is just as correct for points interpolated in clip space as for transformed ones.
+Point3 PatchRenderer::clipToScreen(const Homogeneous4 &transformedPoint) {
+    // Shared with the SIMD kernel's scalar path (PatchKernel.cpp) so the two always agree
+    return clipToViewport(transformedPoint, frameBuffer.width, frameBuffer.height);
+}
+
+// Function to fill a quad of the surface given in clip space, with corners at (s0, t0), (s0, t1),
+// (s1, t0) and (s1, t1). Its triangles are binned for the tiled resolve mode, otherwise they are
+// rasterized straight away with fragments shaded from the (s, t) interpolated across them.
+QuadClipResult PatchRenderer::drawSurfaceQuad(const Homogeneous4 corners[4], float s0, float s1, float t0, float t1) {
+    if (renderParameters->fragmentResolveMode == TILED_DEPTH_BUFFER) {
+        auto binTriangle = [this](const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2) {
+            tileBinner.AddTriangle(v0, v1, v2);
+        };
+        return triangulateQuad(corners, s0, s1, t0, t1, frameBuffer.width, frameBuffer.height, binTriangle);
+    }
+
+    auto writeSurfaceFragment = [this](float x, float y, float z, float s, float t) {
+        writeFragment(Point3(x, y, z), FragmentShade::Surface(s, t));
+    };
+    return rasterizeQuad(kernelLevel, corners, s0, s1, t0, t1, frameBuffer.width, frameBuffer.height, writeSurfaceFragment);
+}
+
+// Function to draw the surface by sampling it on a grid in (s, t) and filling each cell of
+// the grid as two triangles, so there are no holes however close the camera is and no
+// overdraw however far. Takes the control points already transformed to clip space.
+void PatchRenderer::drawMeshSurface(const Homogeneous4 clipControlPoints[16]) {
+    // The adaptive policy sizes the cells so their edges are at most meshEdgePixels long on screen
+    int nStepsS = 1000, nStepsT = 1000;
+    float speedS, speedT;
+    if (renderParameters->samplingPolicy == ADAPTIVE_SAMPLING) {
+        if (projectedNetSpeeds(clipControlPoints, frameBuffer.width, frameBuffer.height, speedS, speedT)) {
+            nStepsS = samplingSteps(speedS, 1.0f / renderParameters->meshEdgePixels);
+            nStepsT = samplingSteps(speedT, 1.0f / renderParameters->meshEdgePixels);
+        } else {
+            // Part of the net is behind the camera, so its size on screen is unbounded
+            nStepsS = nStepsT = MAX_SAMPLE_STEPS;
+        }
+    }
+
+    sBasisTable.Resize(nStepsS);
+    tBasisTable.Resize(nStepsT);
+    evaluatePatchGrid(clipControlPoints, sBasisTable, tBasisTable, meshVertices);
+    int rowLength = nStepsT + 1;
+
+    long quadsCulled = 0, quadsClipped = 0;
+
+    // Every resolve mode but the plain depth buffer can take fragments from several threads at once
+    FragmentResolveMode resolveMode = renderParameters->fragmentResolveMode;
+    #pragma omp parallel if(resolveMode != DEPTH_BUFFER)
+    {
+    TraceScope threadSpan(frameTracer, "bezier mesh rows");
+    #pragma omp for schedule(dynamic, 4) reduction(+:quadsCulled, quadsClipped) nowait
+    for (int s = 0; s < nStepsS; s++) {
+        for (int t = 0; t < nStepsT; t++) {
+            const Homogeneous4 *cell = &meshVertices[s * rowLength + t];
+            Homogeneous4 corners[4] = { cell[0], cell[1], cell[rowLength], cell[rowLength + 1] };
+            QuadClipResult result = drawSurfaceQuad(corners, (float)s / nStepsS, (float)(s + 1) / nStepsS, (float)t / nStepsT, (float)(t + 1) / nStepsT);
+            quadsCulled += result == QUAD_CULLED;
+            quadsClipped += result == QUAD_CLIPPED;
+        }
+    }
+    }
+
+    clipStatistics.quadsIn += (long)nStepsS * nStepsT;
+    clipStatistics.quadsCulled += quadsCulled;
+    clipStatistics.quadsClipped += quadsClipped;
+}
+
+// Function to calculate a bezier point based on a input parameter and 4 control points
+Homogeneous4 PatchRenderer::bezier(float parameter, Homogeneous4 controlPoint1, Homogeneous4 controlPoint2, Homogeneous4 controlPoint3, Homogeneous4 controlPoint4) {
+    // The evaluation itself lives in BezierEvaluation.cpp so it can be tested without Qt
+    return bezierPoint(parameter, controlPoint1, controlPoint2, controlPoint3, controlPoint4);
+}
+
+// Function to draw a line given a start and end point.
+void PatchRenderer::drawLine(Point3 start, Point3 end, RGBAValue colour) {
+    // Transform the ends of the line to clip space, a straight line stays straight under projection
+    Homogeneous4 clipStart = mvpMatrix * Homogeneous4(start);
+    Homogeneous4 clipEnd = mvpMatrix * Homogeneous4(end);
+
+    // Trim the line to the view volume, so nothing outside it is ever rasterized
+    // and both ends are in front of the camera and can be projected
+    // (lines may be drawn from several threads at once, so the counts are updated atomically)
+    #pragma omp atomic
+    clipStatistics.linesIn++;
+    int startOutcode = outcode(clipStart), endOutcode = outcode(clipEnd);
+    if (startOutcode | endOutcode) {
+        if (!clipLine(clipStart, clipEnd)) {
+            #pragma omp atomic
+            clipStatistics.linesCulled++;
+            return;
+        }
+        #pragma omp atomic
+        clipStatistics.linesTrimmed++;
+    }
+
+    // Project the ends once, then step along the line one pixel at a time, so a line costs
+    // as many fragments as it covers pixels rather than a fixed 1000 world space samples
+    RasterVertex startVertex = makeRasterVertex(clipStart, frameBuffer.width, frameBuffer.height, 0.0f, 0.0f);
+    RasterVertex endVertex = makeRasterVertex(clipEnd, frameBuffer.width, frameBuffer.height, 1.0f, 0.0f);
+    Point3 screenStart(startVertex.x, startVertex.y, startVertex.z);
+    Point3 screenEnd(endVertex.x, endVertex.y, endVertex.z);
+
+    // The tiled resolve mode rasterizes it later, a tile at a time
+    FragmentShade shade = FragmentShade::Flat(colour);
+    if (renderParameters->fragmentResolveMode == TILED_DEPTH_BUFFER) {
+        tileBinner.AddLine(screenStart, screenEnd, shade);
+        return;
+    }
+
+    // At most one fragment per pixel along the longer axis
+    if (renderParameters->fragmentResolveMode == PAINTERS_ALGORITHM)
+        fragmentArena.Reserve((size_t)std::max(fabsf(screenEnd.x - screenStart.x), fabsf(screenEnd.y - screenStart.y)) + 2);
+
+    auto writeLineFragment = [&](float x, float y, float z) {
+        writeFragment(Point3(x, y, z), shade);
+    };
+    rasterizeLine(screenStart, screenEnd, frameBuffer.width, frameBuffer.height, writeLineFragment);
+}
+
+// Function to draw a vertex as a point as a circle
+// (Has side effect of staying as a set size regardless of zoom factor)
+void PatchRenderer::drawPoint(Point3 point, RGBAValue colour) {
+    Point3 screenPoint = transformPoint(Homogeneous4(point)); // Transform point to screen space
+
+    // Don't draw the marker at all if its centre is outside the view volume
+    // (points may be drawn from several threads at once, so the counts are updated atomically)
+    #pragma omp atomic
+    clipStatistics.pointsIn++;
+    if (isClippedPoint(screenPoint)) {
+        #pragma omp atomic
+        clipStatistics.pointsCulled++;
+        return;
+    }
+
+    // The tiled resolve mode rasterizes it later, a tile at a time
+    FragmentResolveMode resolveMode = renderParameters->fragmentResolveMode;
+    FragmentShade shade = FragmentShade::Flat(colour);
+    if (resolveMode == TILED_DEPTH_BUFFER) {
+        tileBinner.AddMarker(screenPoint, markerStamp, shade);
+        return;
+    }
+
+    // Every pixel of the precomputed stamp gets a fragment (whilst preserving the z value)
+    PixelRect screen{ 0, 0, frameBuffer.width, frameBuffer.height };
+    if (resolveMode == DEPTH_BUFFER) {
+        // A run of the stamp is depth tested as a whole row, without branches, so it vectorizes
+        auto writePointSpan = [&](long y, long minX, long maxX, float z) {
+            float *depthRow = depthBuffer[(int)y];
+            FragmentShade *shadeRow = shadeBuffer[(int)y];
+            for (long x = minX; x < maxX; x++) {
+                bool nearer = z < depthRow[x];
+                depthRow[x] = nearer ? z : depthRow[x];
+                shadeRow[x].value = nearer ? shade.value : shadeRow[x].value;
+            }
+        };
+        rasterizeMarkerSpans(screenPoint, markerStamp, screen, writePointSpan);
+        return;
+    }
+
+    // With the Painter's algorithm the edge pixels can carry how much of them the marker covers,
+    // and be blended over what is behind them when the fragments are resolved
+    if (resolveMode == PAINTERS_ALGORITHM && renderParameters->antialiasedMarkers) {
+        fragmentArena.Reserve((size_t)(2 * markerStamp.radius + 1) * (2 * markerStamp.radius + 1));
+        auto writeCoverageFragment = [&](float x, float y, float z, uint8_t coverage) {
+            writeFragment(Point3(x, y, z), FragmentShade::Flat(colour, coverage));
+        };
+        rasterizeMarkerCoverage(screenPoint, markerStamp, screen, writeCoverageFragment);
+        return;
+    }
+
+    if (resolveMode == PAINTERS_ALGORITHM)
+        fragmentArena.Reserve(markerStamp.nPixels);
+    auto writePointFragment = [&](float x, float y, float z) {
+        writeFragment(Point3(x, y, z), shade);
+    };
+    rasterizeMarker(screenPoint, markerStamp, screen, writePointFragment);
+}
+
+// Function to hand a screen space fragment to whichever resolve mode is active.
+// For the Painter's algorithm it is stored to be sorted at the end of the frame
+// (in the calling thread's block of the fragment arena, so it is safe from a parallel loop),
+// otherwise it is depth tested straight away. Either way it is only shaded at the
+// end of the frame, and only if it is the nearest at its pixel.
+void PatchRenderer::writeFragment(const Point3 &point, FragmentShade shade) {
+    switch (renderParameters->fragmentResolveMode) {
+        case PAINTERS_ALGORITHM:
+            fragmentArena.Add(Fragment{point, shade});
+            break;
+        case DEPTH_BUFFER:
+            if (depthBuffer.depthTest(point))
+                shadeBuffer[(int)point.y][(int)point.x] = shade;
+            break;
+        case TILED_DEPTH_BUFFER: // binned per thread, safe to call from inside a parallel loop
+            tileBinner.AddFragment(point, shade);
+            break;
+        default: // ATOMIC_DEPTH_BUFFER, safe to call from inside a parallel loop
+            atomicFrameBuffer.depthTest(point, shade);
+            break;
+    }
+}
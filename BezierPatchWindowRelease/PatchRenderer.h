@@ -0,0 +1,143 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  The software renderer for the Bezier patch, with no Qt or OpenGL
+//  Sets up the camera from the render parameters, evaluates and
+//  rasterizes the patch, its control net, markers and reference planes,
+//  and resolves the fragments into a framebuffer, which the widget puts
+//  on screen and the offline renderer writes out
+//
+///////////////////////////////////////////////////
+
+#ifndef PATCH_RENDERER_H
+#define PATCH_RENDERER_H
+
+#include <vector>
+
+#include "ControlPoints.h"
+#include "RenderParameters.h"
+#include "RGBAImage.h"
+#include "DepthBuffer.h"
+#include "ShadeBuffer.h"
+#include "AtomicFrameBuffer.h"
+#include "BezierEvaluation.h"
+#include "PatchKernel.h"
+#include "Subdivision.h"
+#include "SurfaceCache.h"
+#include "Clipping.h"
+#include "TileBinner.h"
+#include "FragmentSorter.h"
+#include "FragmentArena.h"
+#include "MarkerStamp.h"
+#include "FrameTimer.h"
+#include "FrameTracer.h"
+
+// the class itself
+class PatchRenderer
+    { // class PatchRenderer
+	private:
+    // the Bezier patch control points to be rendered
+    ControlPoints *patchControlPoints;
+
+	// the render parameters to use
+	RenderParameters *renderParameters;
+
+	// Depth buffer matching the framebuffer, used instead of sorting
+	// fragments when the depth buffer resolve mode is selected
+	DepthBuffer depthBuffer;
+
+	// What the nearest fragment at each pixel is to be shaded from, filled in
+	// alongside the depth buffer and shaded at the end of the frame
+	ShadeBuffer shadeBuffer;
+
+	// Packed depth & shade framebuffer that any thread can depth test into,
+	// shaded into frameBuffer at the end of the frame
+	AtomicFrameBuffer atomicFrameBuffer;
+
+	// Screen tiles that primitives are binned into and rasterized from in parallel
+	// at the end of the frame, when the tiled resolve mode is selected
+	TileBinner tileBinner;
+
+	// Integer sort keys for the fragments, radix sorted for the Painter's algorithm
+	FragmentSorter fragmentSorter;
+
+	// Bernstein basis values for every sample parameter at the current resolution in s and in t
+	BernsteinTable sBasisTable, tBasisTable;
+
+	// World space samples of the surface, reused while only the camera moves
+	SurfaceCache surfaceCache;
+
+	// Flat pieces of the patch from the last subdivision, kept to reuse the memory
+	std::vector<PatchLeaf> patchLeaves;
+
+	// Clip space vertices of the last triangle mesh, kept to reuse the memory
+	std::vector<Homogeneous4> meshVertices;
+
+	// The disc every control point marker is stamped from
+	MarkerStamp markerStamp;
+
+	// Widest SIMD instruction set the surface kernel can use on this CPU
+	KernelLevel kernelLevel;
+
+	// Projection matrix
+	Matrix4 projectionMatrix;
+	// View matrix
+	Matrix4 viewMatrix;
+	// Model matrix
+	Matrix4 modelMatrix;
+	// Model-view-projection matrix
+	Matrix4 mvpMatrix;
+
+	// adds the time since start to a stage of the frame, and to the trace if tracing,
+	// returning the time now to start the next stage from
+	uint64_t endStage(FrameStage stage, uint64_t start);
+
+	public:
+    // An image to use as a framebuffer ...
+    // ... that we will set individual pixels to
+	RGBAImage frameBuffer;
+
+	// The fragments of the frame for the Painter's algorithm, a block per thread
+	// so they can be added from parallel loops, kept between frames to reuse the memory
+	FragmentArena fragmentArena;
+
+	// How much geometry clipping threw away this frame
+	ClipStatistics clipStatistics;
+
+	// How long each stage of the recent frames took; Render() starts each frame
+	// and times its own stages, the owner times the rest and calls EndFrame()
+	FrameTimer frameTimer;
+
+	// Spans of each stage and of each thread's share of the parallel loops,
+	// recorded only between frameTracer.Start() and Stop()
+	FrameTracer frameTracer;
+
+	// constructor
+	PatchRenderer
+			(
+            // the Bezier patch control points to show
+            ControlPoints 		*newPatchControlPoints,
+			// the render parameters to use
+			RenderParameters 	*newRenderParameters
+			);
+
+	// resizes the framebuffer and everything that matches it
+	void Resize(int w, int h);
+
+	// renders a frame into the framebuffer
+	void Render();
+
+	Point3 transformPoint(Homogeneous4 point);
+	Point3 clipToScreen(const Homogeneous4 &transformedPoint);
+	Homogeneous4 bezier(float parameter, Homogeneous4 controlPoint1, Homogeneous4 controlPoint2, Homogeneous4 controlPoint3, Homogeneous4 controlPoint4);
+	void drawLine(Point3 start, Point3 end, RGBAValue colour);
+	void drawPoint(Point3 point, RGBAValue colour);
+	void writeFragment(const Point3 &point, FragmentShade shade);
+	void drawSampledSurface(const Homogeneous4 clipControlPoints[16], bool needsClipping);
+	void drawCachedSurface(int nStepsS, int nStepsT, bool needsClipping);
+	void drawSubdividedSurface(const Homogeneous4 clipControlPoints[16]);
+	void drawMeshSurface(const Homogeneous4 clipControlPoints[16]);
+	QuadClipResult drawSurfaceQuad(const Homogeneous4 corners[4], float s0, float s1, float t0, float t1);
+
+    }; // class PatchRenderer
+
+#endif
@@ -14,6 +14,7 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <algorithm>
 #include "string.h"
 
 #include "RGBAImage.h"
@@ -244,11 +245,6 @@ void RGBAImage::WritePPM(std::ostream &outStream)
     } // WritePPMFile()
 
 void RGBAImage::clear(RGBAValue color){
-    for (int row = 0; row < height; row++)
-        { // row
-        for (int col = 0; col < width; col++)
-            { // col
-                (*this)[row][col] = color;
-            } // col
-        } // row
+    // one pass over the whole block, which the library can vectorise
+    std::fill(block, block + width * height, color);
 }
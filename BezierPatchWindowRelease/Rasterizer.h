@@ -0,0 +1,382 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  A minimal scan converter for filled triangles, quads, lines and markers in screen space
+//  Depth is interpolated linearly in screen space (as z / w is)
+//  and the (s, t) patch parameters perspective-correctly
+//  
+//  It is a template on whatever writes the fragments out, so the
+//  per-pixel call can be inlined whichever resolve mode is in use
+//  
+///////////////////////////////////////////////////
+
+#ifndef RASTERIZER_H
+#define RASTERIZER_H
+
+#include <math.h>
+#include <algorithm>
+
+#include "Homogeneous4.h"
+#include "Clipping.h"
+#include "TriangleKernel.h"
+#include "MarkerStamp.h"
+
+// a triangle vertex after projection to screen space
+struct RasterVertex
+    { // struct RasterVertex
+    // screen coordinates and normalised device depth
+    float x, y, z;
+    // 1 / w from clip space, for perspective-correct interpolation
+    float invW;
+    // patch parameters at the vertex
+    float s, t;
+    }; // struct RasterVertex
+
+// a rectangle of pixels to rasterize into, from (minX, minY) up to but not including (maxX, maxY)
+// a primitive drawn piecewise into rectangles that tile the screen writes exactly the
+// pixels it would have written drawn into the whole screen at once
+struct PixelRect
+    { // struct PixelRect
+    long minX, minY, maxX, maxY;
+    }; // struct PixelRect
+
+// projects a clip space point to a raster vertex in a viewport of the given size
+// the point must have w > 0
+inline RasterVertex makeRasterVertex(const Homogeneous4 &clipPoint, float width, float height, float s, float t)
+    { // makeRasterVertex()
+    float invW = 1.0f / clipPoint.w;
+    return RasterVertex{ (clipPoint.x * invW + 1) / 2 * width, (clipPoint.y * invW + 1) / 2 * height, clipPoint.z * invW, invW, s, t };
+    } // makeRasterVertex()
+
+// bits of sub-pixel precision vertices are snapped to before filling
+#define RASTER_SUBPIXEL_BITS 8
+#define RASTER_SUBPIXEL_ONE (1L << RASTER_SUBPIXEL_BITS)
+
+// a screen coordinate in sub-pixel units, rounded to nearest with halves away from zero
+// (a plain conversion, which unlike llrintf() is inlined, as this is done for every vertex)
+inline long long snapToSubpixel(float coordinate)
+    { // snapToSubpixel()
+    float scaled = coordinate * RASTER_SUBPIXEL_ONE;
+    return (long long)(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+    } // snapToSubpixel()
+
+// sets a triangle up for filling the pixels in a rectangle whose centres lie inside it
+// vertices are snapped to a sub-pixel grid and the edge functions worked out exactly in
+// integers, so two triangles sharing an edge agree on it and a mesh has no cracks
+// returns false if there is nothing to fill
+inline bool setupTriangle(RasterVertex v0, RasterVertex v1, RasterVertex v2, const PixelRect &bounds, TriangleSetup &setup)
+    { // setupTriangle()
+    if (v0.x != v0.x || v0.y != v0.y || v1.x != v1.x || v1.y != v1.y || v2.x != v2.x || v2.y != v2.y)
+        return false;
+
+    // snap to the sub-pixel grid
+    RasterVertex *v[3] = { &v0, &v1, &v2 };
+    long long fixedX[3], fixedY[3];
+    for (int i = 0; i < 3; i++)
+        { // vertex
+        fixedX[i] = snapToSubpixel(v[i]->x);
+        fixedY[i] = snapToSubpixel(v[i]->y);
+        v[i]->x = (float)fixedX[i] / RASTER_SUBPIXEL_ONE;
+        v[i]->y = (float)fixedY[i] / RASTER_SUBPIXEL_ONE;
+        } // vertex
+
+    // twice the signed area, make the winding counter-clockwise so the edge functions are positive inside
+    long long area = (fixedX[1] - fixedX[0]) * (fixedY[2] - fixedY[0]) - (fixedY[1] - fixedY[0]) * (fixedX[2] - fixedX[0]);
+    if (area == 0)
+        return false;
+    if (area < 0)
+        { // flip winding
+        RasterVertex swap = v1;
+        v1 = v2;
+        v2 = swap;
+        long long swapX = fixedX[1], swapY = fixedY[1];
+        fixedX[1] = fixedX[2]; fixedY[1] = fixedY[2];
+        fixedX[2] = swapX; fixedY[2] = swapY;
+        area = -area;
+        } // flip winding
+
+    // bounding box of pixel centres, clamped to the rectangle, worked out on the sub-pixel grid
+    // (shifting right rounds down, so these are the first and last centres at or inside the box)
+    long long fixedMinX = std::min(fixedX[0], std::min(fixedX[1], fixedX[2])), fixedMaxX = std::max(fixedX[0], std::max(fixedX[1], fixedX[2]));
+    long long fixedMinY = std::min(fixedY[0], std::min(fixedY[1], fixedY[2])), fixedMaxY = std::max(fixedY[0], std::max(fixedY[1], fixedY[2]));
+    setup.minX = std::max((long)bounds.minX, (long)((fixedMinX + RASTER_SUBPIXEL_ONE / 2 - 1) >> RASTER_SUBPIXEL_BITS));
+    setup.maxX = std::min((long)bounds.maxX - 1, (long)((fixedMaxX - RASTER_SUBPIXEL_ONE / 2) >> RASTER_SUBPIXEL_BITS));
+    setup.minY = std::max((long)bounds.minY, (long)((fixedMinY + RASTER_SUBPIXEL_ONE / 2 - 1) >> RASTER_SUBPIXEL_BITS));
+    setup.maxY = std::min((long)bounds.maxY - 1, (long)((fixedMaxY - RASTER_SUBPIXEL_ONE / 2) >> RASTER_SUBPIXEL_BITS));
+    if (setup.minX > setup.maxX || setup.minY > setup.maxY)
+        return false;
+
+    // small enough that every edge function the SIMD kernel works out fits in 32 bits
+    setup.small = fixedMaxX - fixedMinX < TRIANGLE_KERNEL_MAX_SIZE * RASTER_SUBPIXEL_ONE && fixedMaxY - fixedMinY < TRIANGLE_KERNEL_MAX_SIZE * RASTER_SUBPIXEL_ONE;
+
+    // edge functions at the centre of the first pixel, and their steps per pixel
+    long long startX = (long long)setup.minX * RASTER_SUBPIXEL_ONE + RASTER_SUBPIXEL_ONE / 2;
+    long long startY = (long long)setup.minY * RASTER_SUBPIXEL_ONE + RASTER_SUBPIXEL_ONE / 2;
+    for (int i = 0; i < 3; i++)
+        { // edge
+        int from = (i + 1) % 3, to = (i + 2) % 3;
+        long long edgeA = fixedY[from] - fixedY[to];
+        long long edgeB = fixedX[to] - fixedX[from];
+        setup.edgeStart[i] = edgeA * (startX - fixedX[from]) + edgeB * (startY - fixedY[from]);
+        setup.edgeStepX[i] = edgeA * RASTER_SUBPIXEL_ONE;
+        setup.edgeStepY[i] = edgeB * RASTER_SUBPIXEL_ONE;
+        // with counter-clockwise winding, top edges run right to left and left edges downwards
+        bool topLeft = (edgeA == 0 && edgeB < 0) || edgeA > 0;
+        setup.edgeBias[i] = topLeft ? 0 : -1;
+        } // edge
+
+    // each attribute is the vertex values weighted by the edge functions over the area,
+    // which gives planes in screen space for the ones that are linear there
+    // (worked out in double, so the planes are as exact as a float can hold)
+    double invArea = 1.0 / (double)area;
+    auto plane = [&](float a0, float a1, float a2, float &value, float &stepX, float &stepY)
+        { // plane()
+        value = (float)(((double)setup.edgeStart[0] * a0 + (double)setup.edgeStart[1] * a1 + (double)setup.edgeStart[2] * a2) * invArea);
+        stepX = (float)(((double)setup.edgeStepX[0] * a0 + (double)setup.edgeStepX[1] * a1 + (double)setup.edgeStepX[2] * a2) * invArea);
+        stepY = (float)(((double)setup.edgeStepY[0] * a0 + (double)setup.edgeStepY[1] * a1 + (double)setup.edgeStepY[2] * a2) * invArea);
+        }; // plane()
+
+    // depth is already divided through by w, and the parameters are divided by w for perspective correction
+    plane(v0.z, v1.z, v2.z, setup.z, setup.zStepX, setup.zStepY);
+    plane(v0.invW, v1.invW, v2.invW, setup.invW, setup.invWStepX, setup.invWStepY);
+    plane(v0.s * v0.invW, v1.s * v1.invW, v2.s * v2.invW, setup.sOverW, setup.sOverWStepX, setup.sOverWStepY);
+    plane(v0.t * v0.invW, v1.t * v1.invW, v2.t * v2.invW, setup.tOverW, setup.tOverWStepX, setup.tOverWStepY);
+    return true;
+    } // setupTriangle()
+
+// fills a triangle, calling writeFragment(x, y, z, s, t) for every pixel in the rectangle whose
+// centre lies inside it and whose depth is inside the view volume
+// pixels on an edge shared by two triangles are only written by one (top-left rule)
+// triangles up to TRIANGLE_KERNEL_MAX_SIZE across are filled two rows at a time by the SIMD kernel
+// at the given level, larger ones a pixel at a time with 64 bit edge functions, with the same results
+template <typename FragmentWriter>
+void rasterizeTriangle(KernelLevel level, const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2, const PixelRect &bounds, FragmentWriter &writeFragment)
+    { // rasterizeTriangle()
+    TriangleSetup setup;
+    if (!setupTriangle(v0, v1, v2, bounds, setup))
+        return;
+
+    if (setup.small)
+        { // small
+        int x[2 * TRIANGLE_KERNEL_MAX_ROW];
+        float z[2 * TRIANGLE_KERNEL_MAX_ROW], s[2 * TRIANGLE_KERNEL_MAX_ROW], t[2 * TRIANGLE_KERNEL_MAX_ROW];
+        for (long y = setup.minY; y <= setup.maxY; y += 2)
+            { // pair of rows
+            int nCovered[2];
+            fillTriangleRows(level, setup, y, x, z, s, t, nCovered);
+            for (int row = 0; row < 2; row++)
+                for (int i = row * TRIANGLE_KERNEL_MAX_ROW; i < row * TRIANGLE_KERNEL_MAX_ROW + nCovered[row]; i++)
+                    writeFragment(x[i] + 0.5f, y + row + 0.5f, z[i], s[i], t[i]);
+            } // pair of rows
+        return;
+        } // small
+
+    for (long y = setup.minY; y <= setup.maxY; y++)
+        { // row
+        long rowOffset = y - setup.minY;
+        long long weight[3];
+        for (int i = 0; i < 3; i++)
+            weight[i] = setup.edgeStart[i] + setup.edgeStepY[i] * rowOffset + setup.edgeBias[i];
+
+        // the planes at the start of the row, stepped across it in the same way as the kernel does
+        float z = setup.z + setup.zStepY * (float)rowOffset;
+        float invW = setup.invW + setup.invWStepY * (float)rowOffset;
+        float sOverW = setup.sOverW + setup.sOverWStepY * (float)rowOffset;
+        float tOverW = setup.tOverW + setup.tOverWStepY * (float)rowOffset;
+
+        for (long x = setup.minX; x <= setup.maxX; x++, weight[0] += setup.edgeStepX[0], weight[1] += setup.edgeStepX[1], weight[2] += setup.edgeStepX[2])
+            { // pixel
+            // reject pixels outside or on a non top-left edge
+            if ((weight[0] | weight[1] | weight[2]) < 0)
+                continue;
+
+            float offset = (float)(x - setup.minX);
+            float pixelZ = z + setup.zStepX * offset;
+            if (pixelZ < -1.0f || pixelZ > 1.0f)
+                continue;
+
+            // perspective-correct parameters
+            float pixelW = 1.0f / (invW + setup.invWStepX * offset);
+            writeFragment(x + 0.5f, y + 0.5f, pixelZ, (sOverW + setup.sOverWStepX * offset) * pixelW, (tOverW + setup.tOverWStepX * offset) * pixelW);
+            } // pixel
+        } // row
+    } // rasterizeTriangle()
+
+// fills a triangle a pixel at a time, for checking the kernel against
+template <typename FragmentWriter>
+void rasterizeTriangle(const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2, const PixelRect &bounds, FragmentWriter &writeFragment)
+    { // rasterizeTriangle()
+    rasterizeTriangle(KERNEL_SCALAR, v0, v1, v2, bounds, writeFragment);
+    } // rasterizeTriangle()
+
+// fills a triangle anywhere in a viewport of the given size
+template <typename FragmentWriter>
+void rasterizeTriangle(const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2, long width, long height, FragmentWriter &writeFragment)
+    { // rasterizeTriangle()
+    rasterizeTriangle(KERNEL_SCALAR, v0, v1, v2, PixelRect{ 0, 0, width, height }, writeFragment);
+    } // rasterizeTriangle()
+
+// what rasterizeQuad() did with a quad
+enum QuadClipResult
+    { // enum QuadClipResult
+    QUAD_INSIDE,
+    QUAD_CULLED,
+    QUAD_CLIPPED
+    }; // enum QuadClipResult
+
+// splits a quad of the patch given in clip space, with corners at (s0, t0), (s0, t1), (s1, t0)
+// and (s1, t1), into screen space triangles and calls emitTriangle(v0, v1, v2) for each
+// quads inside the view volume give two triangles split along the (s0, t0) - (s1, t1) diagonal,
+// quads partly outside it are clipped first and given as a fan,
+// and quads with every corner outside one plane give none
+template <typename TriangleEmitter>
+QuadClipResult triangulateQuad(const Homogeneous4 corners[4], float s0, float s1, float t0, float t1, long width, long height, TriangleEmitter &emitTriangle)
+    { // triangulateQuad()
+    int outcodes[4];
+    for (int corner = 0; corner < 4; corner++)
+        outcodes[corner] = outcode(corners[corner]);
+
+    // quads entirely inside are drawn as they are, which is nearly all of them
+    if ((outcodes[0] | outcodes[1] | outcodes[2] | outcodes[3]) == 0)
+        { // inside
+        RasterVertex vertices[4] = {
+            makeRasterVertex(corners[0], width, height, s0, t0),
+            makeRasterVertex(corners[1], width, height, s0, t1),
+            makeRasterVertex(corners[2], width, height, s1, t0),
+            makeRasterVertex(corners[3], width, height, s1, t1) };
+        emitTriangle(vertices[0], vertices[1], vertices[3]);
+        emitTriangle(vertices[0], vertices[3], vertices[2]);
+        return QUAD_INSIDE;
+        } // inside
+
+    // all four corners outside one plane, so the whole quad is
+    if (outcodes[0] & outcodes[1] & outcodes[2] & outcodes[3])
+        return QUAD_CULLED;
+
+    // otherwise clip the quad (its corners in order around it) and give what is left as a fan
+    ClipVertex quad[4] = {
+        ClipVertex{ corners[0], s0, t0 }, ClipVertex{ corners[1], s0, t1 },
+        ClipVertex{ corners[3], s1, t1 }, ClipVertex{ corners[2], s1, t0 } };
+    ClipVertex clipped[MAX_CLIP_VERTICES];
+    int nClipped = clipPolygon(quad, 4, clipped);
+
+    RasterVertex fan[MAX_CLIP_VERTICES];
+    for (int v = 0; v < nClipped; v++)
+        fan[v] = makeRasterVertex(clipped[v].position, width, height, clipped[v].s, clipped[v].t);
+    for (int v = 1; v + 1 < nClipped; v++)
+        emitTriangle(fan[0], fan[v], fan[v + 1]);
+    return QUAD_CLIPPED;
+    } // triangulateQuad()
+
+// fills a quad of the patch given in clip space, with its corners as for triangulateQuad(),
+// using the triangle kernel at the given level
+template <typename FragmentWriter>
+QuadClipResult rasterizeQuad(KernelLevel level, const Homogeneous4 corners[4], float s0, float s1, float t0, float t1, long width, long height, FragmentWriter &writeFragment)
+    { // rasterizeQuad()
+    auto fillTriangle = [&](const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2)
+        { rasterizeTriangle(level, v0, v1, v2, PixelRect{ 0, 0, width, height }, writeFragment); };
+    return triangulateQuad(corners, s0, s1, t0, t1, width, height, fillTriangle);
+    } // rasterizeQuad()
+
+// draws a line between two screen space points with a DDA: it visits each pixel centre
+// along whichever axis the line is longer in, from one end to the other, and calls
+// writeFragment(x, y, z) with the centre of the pixel the line crosses there, if that
+// is inside the viewport and its depth is inside the view volume
+// only the centres inside the rectangle are visited, so a line that runs far off
+// screen costs no more than the part that is on it
+template <typename FragmentWriter>
+void rasterizeLine(const Point3 &start, const Point3 &end, const PixelRect &bounds, FragmentWriter &writeFragment)
+    { // rasterizeLine()
+    float dx = end.x - start.x, dy = end.y - start.y, dz = end.z - start.z;
+    if (dx != dx || dy != dy)
+        return;
+
+    // step one pixel at a time along the major axis
+    bool xMajor = fabsf(dx) >= fabsf(dy);
+    float majorStart = xMajor ? start.x : start.y, majorEnd = xMajor ? end.x : end.y;
+    float majorLength = xMajor ? dx : dy;
+    long majorMin = xMajor ? bounds.minX : bounds.minY, majorMax = xMajor ? bounds.maxX : bounds.maxY;
+    long minorMin = xMajor ? bounds.minY : bounds.minX, minorMax = xMajor ? bounds.maxY : bounds.maxX;
+    float minorStart = xMajor ? start.y : start.x, minorLength = xMajor ? dy : dx;
+
+    // pixel centres between the ends, clamped to the rectangle
+    long first = (long)fmaxf((float)majorMin, ceilf(fminf(majorStart, majorEnd) - 0.5f));
+    long last = (long)fminf((float)majorMax - 1.0f, floorf(fmaxf(majorStart, majorEnd) - 0.5f));
+
+    for (long major = first; major <= last; major++)
+        { // step
+        float fraction = majorLength != 0.0f ? (major + 0.5f - majorStart) / majorLength : 0.0f;
+        float minor = floorf(minorStart + minorLength * fraction);
+        if (minor < minorMin || minor >= minorMax)
+            continue;
+
+        // depth is already divided through by w, so is linear in screen space
+        float z = start.z + dz * fraction;
+        if (z < -1.0f || z > 1.0f)
+            continue;
+
+        if (xMajor)
+            writeFragment(major + 0.5f, minor + 0.5f, z);
+        else
+            writeFragment(minor + 0.5f, major + 0.5f, z);
+        } // step
+    } // rasterizeLine()
+
+// draws a line anywhere in a viewport of the given size
+template <typename FragmentWriter>
+void rasterizeLine(const Point3 &start, const Point3 &end, long width, long height, FragmentWriter &writeFragment)
+    { // rasterizeLine()
+    rasterizeLine(start, end, PixelRect{ 0, 0, width, height }, writeFragment);
+    } // rasterizeLine()
+
+// stamps a round marker around a screen space point, all at its depth, calling
+// writeSpan(y, minX, maxX, z) for each run of pixels from minX up to but not including maxX
+// in the rectangle it covers
+// the stamp is centred on the pixel the point lies in, so a marker is the same shape
+// wherever it lies on screen
+template <typename SpanWriter>
+void rasterizeMarkerSpans(const Point3 &centre, const MarkerStamp &stamp, const PixelRect &bounds, SpanWriter &writeSpan)
+    { // rasterizeMarkerSpans()
+    long centreX = (long)floorf(centre.x), centreY = (long)floorf(centre.y);
+    long minY = std::max(bounds.minY, centreY - stamp.radius), maxY = std::min(bounds.maxY, centreY + stamp.radius + 1);
+    for (long y = minY; y < maxY; y++)
+        { // row
+        int row = (int)(y - centreY) + stamp.radius;
+        long minX = std::max(bounds.minX, centreX + stamp.spanStarts[row]);
+        long maxX = std::min(bounds.maxX, centreX + stamp.spanEnds[row]);
+        if (minX < maxX)
+            writeSpan(y, minX, maxX, centre.z);
+        } // row
+    } // rasterizeMarkerSpans()
+
+// stamps a round marker around a screen space point, all at its depth,
+// calling writeFragment(x, y, z) with the corner of every pixel in the rectangle it covers
+template <typename FragmentWriter>
+void rasterizeMarker(const Point3 &centre, const MarkerStamp &stamp, const PixelRect &bounds, FragmentWriter &writeFragment)
+    { // rasterizeMarker()
+    auto writeSpan = [&writeFragment](long y, long minX, long maxX, float z)
+        { // writeSpan()
+        for (long x = minX; x < maxX; x++)
+            writeFragment((float)x, (float)y, z);
+        }; // writeSpan()
+    rasterizeMarkerSpans(centre, stamp, bounds, writeSpan);
+    } // rasterizeMarker()
+
+// stamps an anti-aliased round marker around a screen space point, all at its depth, calling
+// writeFragment(x, y, z, coverage) with the corner of every pixel in the rectangle the disc
+// covers any of, and how much of the pixel it covers, from 1 to 255
+template <typename FragmentWriter>
+void rasterizeMarkerCoverage(const Point3 &centre, const MarkerStamp &stamp, const PixelRect &bounds, FragmentWriter &writeFragment)
+    { // rasterizeMarkerCoverage()
+    long centreX = (long)floorf(centre.x), centreY = (long)floorf(centre.y);
+    long minY = std::max(bounds.minY, centreY - stamp.radius), maxY = std::min(bounds.maxY, centreY + stamp.radius + 1);
+    long minX = std::max(bounds.minX, centreX - stamp.radius), maxX = std::min(bounds.maxX, centreX + stamp.radius + 1);
+    for (long y = minY; y < maxY; y++)
+        for (long x = minX; x < maxX; x++)
+            { // pixel
+            uint8_t coverage = stamp.Coverage((int)(x - centreX), (int)(y - centreY));
+            if (coverage != 0)
+                writeFragment((float)x, (float)y, centre.z, coverage);
+            } // pixel
+    } // rasterizeMarkerCoverage()
+
+#endif
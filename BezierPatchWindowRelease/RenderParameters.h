@@ -22,6 +22,58 @@ class ControlPoints;
 #include "ControlPoints.h"
 #include "RGBAValue.h"
 
+// ways of resolving fragments into the framebuffer
+enum FragmentResolveMode
+    { // enum FragmentResolveMode
+    // sort every fragment and draw them back to front
+    PAINTERS_ALGORITHM,
+    // depth test each fragment against a per-pixel depth buffer as it is written
+    DEPTH_BUFFER,
+    // lock-free depth test into packed depth & colour atomics, so the surface can be written in parallel
+    ATOMIC_DEPTH_BUFFER,
+    // bin primitives into screen tiles and rasterize & depth test each tile on its own thread
+    TILED_DEPTH_BUFFER,
+    // number of modes, for cycling through them
+    N_FRAGMENT_RESOLVE_MODES
+    }; // enum FragmentResolveMode
+
+// ways of evaluating the samples of the Bezier surface
+enum SurfaceEvaluationMode
+    { // enum SurfaceEvaluationMode
+    // evaluate the Bernstein polynomials in full for every sample
+    DIRECT_EVALUATION,
+    // step along each row of samples with forward differences
+    FORWARD_DIFFERENCES,
+    // contract the control net with tables of precomputed basis values
+    BASIS_TABLE,
+    // evaluate, clip and project whole rows with the AVX2/SSE kernel
+    SIMD_KERNEL,
+    // number of modes, for cycling through them
+    N_SURFACE_EVALUATION_MODES
+    }; // enum SurfaceEvaluationMode
+
+// ways of drawing the Bezier surface
+enum SurfaceRenderer
+    { // enum SurfaceRenderer
+    // sample it on a grid and draw each sample as a point
+    SAMPLED_POINTS,
+    // subdivide it until each piece is flat on screen and fill the pieces
+    RECURSIVE_SUBDIVISION,
+    // sample it on a grid and fill the grid as a mesh of triangles
+    TRIANGLE_MESH,
+    // number of renderers, for cycling through them
+    N_SURFACE_RENDERERS
+    }; // enum SurfaceRenderer
+
+// ways of choosing how many samples to take of the Bezier surface
+enum SamplingPolicy
+    { // enum SamplingPolicy
+    // always 1001 x 1001 samples
+    FIXED_SAMPLING,
+    // enough samples for samplesPerPixel wherever the patch moves fastest on screen
+    ADAPTIVE_SAMPLING
+    }; // enum SamplingPolicy
+
 // class for the render parameters
 class RenderParameters
     { // class RenderParameters
@@ -54,6 +106,32 @@ class RenderParameters
     bool orthoProjection;
     bool triggerResize;
 
+    // how the software renderer draws the surface
+    SurfaceRenderer surfaceRenderer;
+    // how far on screen a subdivided piece may stray from a flat quad, in pixels
+    float subdivisionFlatness;
+    // longest the edges of the triangle mesh may be on screen, in pixels
+    float meshEdgePixels;
+    // how the software renderer resolves fragments into pixels
+    FragmentResolveMode fragmentResolveMode;
+    // and how it evaluates the surface samples
+    SurfaceEvaluationMode surfaceEvaluationMode;
+    // and how many samples it takes of the surface
+    SamplingPolicy samplingPolicy;
+    // target sample density for adaptive sampling, above 1 so there are no holes
+    float samplesPerPixel;
+    // keep the world space samples between frames while the control net is unchanged
+    bool cacheTessellation;
+    // write the next software rendered frame out to a PPM file
+    bool saveFrame;
+    // draw the rolling stage times over the software rendered frame
+    bool timingOverlayEnabled;
+    // record each thread's spans of work, written to a Chrome trace when turned off
+    bool tracingEnabled;
+    // blend the edges of the control point markers by how much of each pixel they cover
+    // (with the Painter's algorithm, the other resolve modes keep only the nearest fragment)
+    bool antialiasedMarkers;
+
     // width and height of window, plus initial value
     int windowSize;
     int windowWidth, windowHeight;
@@ -73,6 +151,18 @@ class RenderParameters
         bezierEnabled(false),
         orthoProjection(true),
         triggerResize(false),
+        surfaceRenderer(SAMPLED_POINTS),
+        subdivisionFlatness(0.25f),
+        meshEdgePixels(4.0f),
+        fragmentResolveMode(ATOMIC_DEPTH_BUFFER),
+        surfaceEvaluationMode(SIMD_KERNEL),
+        samplingPolicy(ADAPTIVE_SAMPLING),
+        samplesPerPixel(1.5f),
+        cacheTessellation(true),
+        saveFrame(false),
+        timingOverlayEnabled(false),
+        tracingEnabled(false),
+        antialiasedMarkers(false),
         theClearColor{0.8f, 0.8f, 0.6f, 1.0f},
         windowSize(640),
         activeVertex(0),
@@ -25,7 +25,9 @@
 // include the header file
 #include "RenderWidget.h"
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <GL/gl.h>
 #include <GL/glu.h>
 
@@ -348,32 +350,32 @@ void RenderWidget::keyPressEvent(QKeyEvent *event)
 
     case Qt::Key_Left:
             // move the active vertex
-            renderParameters->patchControlPoints->vertices[renderParameters->activeVertex].x -= 0.1f;
+            renderParameters->patchControlPoints->MoveVertex(renderParameters->activeVertex, Vector3(-0.1f, 0.0f, 0.0f));
         break;
 
     case Qt::Key_Right:
             // move the active vertex
-            renderParameters->patchControlPoints->vertices[renderParameters->activeVertex].x += 0.1f;
+            renderParameters->patchControlPoints->MoveVertex(renderParameters->activeVertex, Vector3(0.1f, 0.0f, 0.0f));
         break;
 
     case Qt::Key_Up:
             // move the active vertex
-            renderParameters->patchControlPoints->vertices[renderParameters->activeVertex].y += 0.1f;
+            renderParameters->patchControlPoints->MoveVertex(renderParameters->activeVertex, Vector3(0.0f, 0.1f, 0.0f));
         break;
 
     case Qt::Key_Down:
             // move the active vertex
-            renderParameters->patchControlPoints->vertices[renderParameters->activeVertex].y -= 0.1f;
+            renderParameters->patchControlPoints->MoveVertex(renderParameters->activeVertex, Vector3(0.0f, -0.1f, 0.0f));
         break;
 
     case Qt::Key_Plus:
             // move the active vertex
-            renderParameters->patchControlPoints->vertices[renderParameters->activeVertex].z += 0.1f;
+            renderParameters->patchControlPoints->MoveVertex(renderParameters->activeVertex, Vector3(0.0f, 0.0f, 0.1f));
         break;
 
     case Qt::Key_Minus:
             // move the active vertex
-            renderParameters->patchControlPoints->vertices[renderParameters->activeVertex].z -= 0.1f;
+            renderParameters->patchControlPoints->MoveVertex(renderParameters->activeVertex, Vector3(0.0f, 0.0f, -0.1f));
         break;
 
     case Qt::Key_P:
@@ -396,6 +398,51 @@ void RenderWidget::keyPressEvent(QKeyEvent *event)
         renderParameters->bezierEnabled = !renderParameters->bezierEnabled;
         break;
 
+    case Qt::Key_D:
+            // cycle through the ways the software renderer resolves fragments
+        renderParameters->fragmentResolveMode = FragmentResolveMode((renderParameters->fragmentResolveMode + 1) % N_FRAGMENT_RESOLVE_MODES);
+        break;
+
+    case Qt::Key_E:
+            // cycle through the ways the software renderer evaluates the surface
+        renderParameters->surfaceEvaluationMode = SurfaceEvaluationMode((renderParameters->surfaceEvaluationMode + 1) % N_SURFACE_EVALUATION_MODES);
+        break;
+
+    case Qt::Key_A:
+            // toggle between fixed and adaptive sampling of the surface
+        renderParameters->samplingPolicy = renderParameters->samplingPolicy == ADAPTIVE_SAMPLING ? FIXED_SAMPLING : ADAPTIVE_SAMPLING;
+        break;
+
+    case Qt::Key_R:
+            // cycle through the ways the software renderer draws the surface
+        renderParameters->surfaceRenderer = SurfaceRenderer((renderParameters->surfaceRenderer + 1) % N_SURFACE_RENDERERS);
+        break;
+
+    case Qt::Key_C:
+            // toggle keeping the world space surface samples between frames
+        renderParameters->cacheTessellation = !renderParameters->cacheTessellation;
+        break;
+
+    case Qt::Key_S:
+            // save the next software rendered frame so the resolve modes can be compared
+        renderParameters->saveFrame = true;
+        break;
+
+    case Qt::Key_T:
+            // toggle the stage times drawn over the software rendered frame
+        renderParameters->timingOverlayEnabled = !renderParameters->timingOverlayEnabled;
+        break;
+
+    case Qt::Key_F:
+            // start or stop tracing the software renderer's frames, writing the trace when it stops
+        renderParameters->tracingEnabled = !renderParameters->tracingEnabled;
+        break;
+
+    case Qt::Key_M:
+            // toggle blending the marker edges, with the Painter's algorithm
+        renderParameters->antialiasedMarkers = !renderParameters->antialiasedMarkers;
+        break;
+
     }
 
     this->forceRepaint();
@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  A minimal class for a per-pixel buffer of what to shade each pixel from
+//  Laid out exactly like RGBAImage and DepthBuffer so the three can be
+//  indexed together: the depth test keeps the nearest fragment's shade
+//  here, and only those are turned into colours at the end of the frame
+//  
+///////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <algorithm>
+
+#include "ShadeBuffer.h"
+
+// constructor
+ShadeBuffer::ShadeBuffer()
+    :
+    block(nullptr),
+    width(0),
+    height(0)
+    { // ShadeBuffer constructor
+    } // ShadeBuffer constructor
+
+//  destructor
+ShadeBuffer::~ShadeBuffer()
+    { // ShadeBuffer destructor
+    // release the memory
+    free(block);
+    } // ShadeBuffer destructor
+
+// resizes the buffer, destroying any contents
+bool ShadeBuffer::Resize(long Width, long Height)
+    { // Resize()
+    // check validity of dimensions
+    if ((Width < 0) || (Height < 0))
+        return false;
+
+    // if our old block is non-null
+    if (block != nullptr)
+        // release the old pointer
+        free(block);
+
+    // no need to zero, the buffer is cleared at the start of every frame
+    block = static_cast<FragmentShade *>(malloc(static_cast<unsigned long>(Height * Width) * sizeof (FragmentShade)));
+    if (block == nullptr)
+        return false;
+
+    // now that it's reallocated, reset the parameters
+    height = Height;
+    width = Width;
+
+    // done
+    return true;
+    } // Resize()
+
+// indexing - retrieves the beginning of a line
+// array indexing will then retrieve an element
+FragmentShade * ShadeBuffer::operator [](const int rowIndex)
+    { // row [] index operator
+    // use pointer arithmetic to compute the row beginning
+    return block+(rowIndex*width);
+    } // [] row index operator
+
+// similar routine for const pointers
+const FragmentShade * ShadeBuffer::operator [](const int rowIndex) const
+    { // row [] index operator
+    // use pointer arithmetic to compute the row beginning
+    return block+(rowIndex*width);
+    } // [] row index operator
+
+// helper routine to clear
+void ShadeBuffer::clear(FragmentShade shade)
+    { // clear()
+    std::fill(block, block + width * height, shade);
+    } // clear()
@@ -0,0 +1,61 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  A minimal class for a per-pixel buffer of what to shade each pixel from
+//  Laid out exactly like RGBAImage and DepthBuffer so the three can be
+//  indexed together: the depth test keeps the nearest fragment's shade
+//  here, and only those are turned into colours at the end of the frame
+//  
+///////////////////////////////////////////////////
+
+#ifndef SHADEBUFFER_H
+#define SHADEBUFFER_H
+
+#include "FragmentShade.h"
+#include "RGBAImage.h"
+
+// the class itself
+class ShadeBuffer
+    { // class ShadeBuffer
+    public:
+    //  the raw data, one shade per pixel
+    FragmentShade *block;
+
+    // dimensions of the buffer
+    long width, height;
+
+    // constructor
+    ShadeBuffer();
+
+    // destructor
+    ~ShadeBuffer();
+
+    // resizes the buffer, destroying any contents
+    bool Resize(long Width, long Height);
+
+    // indexing - retrieves the beginning of a line
+    // array indexing will then retrieve an element
+    FragmentShade * operator [](const int rowIndex);
+
+    // similar routine for const pointers
+    const FragmentShade * operator [](const int rowIndex) const;
+
+    // helper routine to clear (usually to the flat background colour)
+    void clear(FragmentShade shade);
+
+    // colours every pixel of an image of the same size with shade(FragmentShade)
+    template <typename Shader>
+    void resolve(RGBAImage &image, const Shader &shade) const;
+
+    }; // class ShadeBuffer
+
+// colours every pixel of an image of the same size with shade(FragmentShade)
+template <typename Shader>
+void ShadeBuffer::resolve(RGBAImage &image, const Shader &shade) const
+    { // resolve()
+    long nPixels = width * height;
+    #pragma omp parallel for
+    for (long i = 0; i < nPixels; i++)
+        image.block[i] = shade(block[i]);
+    } // resolve()
+
+#endif
@@ -0,0 +1,135 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  Recursive de Casteljau subdivision of a bicubic patch
+//  Splits until each piece is flat enough on screen (or smaller
+//  than a pixel) to be drawn as a quad, so curved regions are
+//  refined and flat ones stay cheap
+//  
+///////////////////////////////////////////////////
+
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Subdivision.h"
+#include "Tessellation.h"
+#include "Clipping.h"
+
+// how many levels deep to keep spawning tasks, below this each task recurses on its own
+#define SUBDIVISION_TASK_DEPTH 8
+
+// everything one recursion needs that does not change from piece to piece
+struct SubdivisionContext
+    { // struct SubdivisionContext
+    float width, height, flatness;
+    // one list of leaves per thread so tasks never contend on them
+    std::vector<std::vector<PatchLeaf>> threadLeaves;
+    }; // struct SubdivisionContext
+
+// true if all 16 control points are outside the same clip plane, in which case
+// the convex hull, and so the whole piece, is outside the view volume
+static bool outsideOnePlane(const Homogeneous4 controlPoints[16])
+    { // outsideOnePlane()
+    // one bit per plane: -x, +x, -y, +y, -z, +z
+    int allOutside = 63;
+    for (int i = 0; i < 16 && allOutside; i++)
+        allOutside &= outcode(controlPoints[i]);
+    return allOutside != 0;
+    } // outsideOnePlane()
+
+// largest distance on screen of any control point from the bilinear quad through the corners
+// the projected piece lies in the hull of its control points, so this bounds how far it is from the quad
+static float screenFlatness(const Homogeneous4 controlPoints[16], float width, float height)
+    { // screenFlatness()
+    float screenX[16], screenY[16];
+    for (int i = 0; i < 16; i++)
+        { // control point
+        screenX[i] = (controlPoints[i].x / controlPoints[i].w + 1) / 2 * width;
+        screenY[i] = (controlPoints[i].y / controlPoints[i].w + 1) / 2 * height;
+        } // control point
+
+    float worst = 0.0f;
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            { // control point
+            float u = i / 3.0f, v = j / 3.0f;
+            float quadX = (1 - u) * ((1 - v) * screenX[0] + v * screenX[3]) + u * ((1 - v) * screenX[12] + v * screenX[15]);
+            float quadY = (1 - u) * ((1 - v) * screenY[0] + v * screenY[3]) + u * ((1 - v) * screenY[12] + v * screenY[15]);
+            worst = fmaxf(worst, hypotf(screenX[i * 4 + j] - quadX, screenY[i * 4 + j] - quadY));
+            } // control point
+    return worst;
+    } // screenFlatness()
+
+// the recursion itself
+static void subdivide(const Homogeneous4 controlPoints[16], float s0, float s1, float t0, float t1, int depth, SubdivisionContext &context)
+    { // subdivide()
+    if (outsideOnePlane(controlPoints))
+        return;
+
+    // measure the piece on screen, which fails if it crosses the plane of the eye
+    float lengthS, lengthT;
+    bool projectable = projectedNetLengths(controlPoints, context.width, context.height, lengthS, lengthT);
+
+    if (projectable && ((lengthS <= 1.0f && lengthT <= 1.0f) || screenFlatness(controlPoints, context.width, context.height) <= context.flatness))
+        { // leaf
+#ifdef _OPENMP
+        std::vector<PatchLeaf> &leaves = context.threadLeaves[omp_get_thread_num()];
+#else
+        std::vector<PatchLeaf> &leaves = context.threadLeaves[0];
+#endif
+        leaves.push_back(PatchLeaf{ { controlPoints[0], controlPoints[3], controlPoints[12], controlPoints[15] }, s0, s1, t0, t1 });
+        return;
+        } // leaf
+
+    // pieces that still cross the eye plane this deep are too small to matter
+    if (depth >= MAX_SUBDIVISION_DEPTH)
+        return;
+
+    // split across the longer direction on screen (alternating if it cannot be measured)
+    bool splitS = projectable ? lengthS >= lengthT : depth % 2 == 0;
+    Homogeneous4 first[16], second[16];
+    if (splitS)
+        { // split s
+        for (int j = 0; j < 4; j++)
+            splitCurve(controlPoints + j, 4, first + j, second + j);
+        } // split s
+    else
+        { // split t
+        for (int i = 0; i < 4; i++)
+            splitCurve(controlPoints + i * 4, 1, first + i * 4, second + i * 4);
+        } // split t
+
+    float sMiddle = 0.5f * (s0 + s1), tMiddle = 0.5f * (t0 + t1);
+    float firstS1 = splitS ? sMiddle : s1, firstT1 = splitS ? t1 : tMiddle;
+    float secondS0 = splitS ? sMiddle : s0, secondT0 = splitS ? t0 : tMiddle;
+
+    // hand the first half to another thread while near the top of the tree
+    #pragma omp task firstprivate(first) shared(context) if(depth < SUBDIVISION_TASK_DEPTH)
+    subdivide(first, s0, firstS1, t0, firstT1, depth + 1, context);
+
+    subdivide(second, secondS0, s1, secondT0, t1, depth + 1, context);
+    } // subdivide()
+
+// subdivides the patch until every piece is flat enough on screen
+void subdividePatch(const Homogeneous4 clipControlPoints[16], float width, float height, float flatness, std::vector<PatchLeaf> &leaves)
+    { // subdividePatch()
+    SubdivisionContext context;
+    context.width = width;
+    context.height = height;
+    context.flatness = flatness;
+#ifdef _OPENMP
+    context.threadLeaves.resize(omp_get_max_threads());
+#else
+    context.threadLeaves.resize(1);
+#endif
+
+    #pragma omp parallel
+    #pragma omp single
+    subdivide(clipControlPoints, 0.0f, 1.0f, 0.0f, 1.0f, 0, context);
+
+    // gather the leaves from every thread
+    leaves.clear();
+    for (const std::vector<PatchLeaf> &threadLeaves : context.threadLeaves)
+        leaves.insert(leaves.end(), threadLeaves.begin(), threadLeaves.end());
+    } // subdividePatch()
@@ -0,0 +1,36 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  Recursive de Casteljau subdivision of a bicubic patch
+//  Splits until each piece is flat enough on screen (or smaller
+//  than a pixel) to be drawn as a quad, so curved regions are
+//  refined and flat ones stay cheap
+//  
+///////////////////////////////////////////////////
+
+#ifndef SUBDIVISION_H
+#define SUBDIVISION_H
+
+#include <vector>
+
+#include "Homogeneous4.h"
+
+// deepest the subdivision may go, splitting one direction per level
+#define MAX_SUBDIVISION_DEPTH 24
+
+// a flat enough piece of the patch, in clip space
+struct PatchLeaf
+    { // struct PatchLeaf
+    // corners at (s0, t0), (s0, t1), (s1, t0), (s1, t1)
+    Homogeneous4 corners[4];
+    // the range of the patch parameters it covers
+    float s0, s1, t0, t1;
+    }; // struct PatchLeaf
+
+// subdivides the patch with clip space control points (row major, s down the rows)
+// until every piece deviates from its corners' bilinear quad by at most flatness pixels
+// pieces entirely outside the view volume are dropped along the way
+// the subdivision is split across threads with OpenMP tasks, and the leaves are
+// returned in no particular order
+void subdividePatch(const Homogeneous4 clipControlPoints[16], float width, float height, float flatness, std::vector<PatchLeaf> &leaves);
+
+#endif
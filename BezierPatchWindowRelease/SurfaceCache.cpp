@@ -0,0 +1,125 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  World space samples of the patch and their shades, kept
+//  between frames so a frame that only moves the camera
+//  just transforms and rasterises them
+//  
+///////////////////////////////////////////////////
+
+#include "SurfaceCache.h"
+
+// constructor, empty until built
+SurfaceCache::SurfaceCache()
+    : version(0), nStepsS(0), nStepsT(0), built(false), nUpdates(0)
+    { // SurfaceCache()
+    } // SurfaceCache()
+
+// whether the samples can be reused for this frame
+bool SurfaceCache::Fits(unsigned long controlPointsVersion, int wantedStepsS, int wantedStepsT) const
+    { // Fits()
+    return built && version == controlPointsVersion && Covers(wantedStepsS, wantedStepsT);
+    } // Fits()
+
+// whether the resolution can stand in for the one wanted
+bool SurfaceCache::Covers(int wantedStepsS, int wantedStepsT) const
+    { // Covers()
+    // too few samples would leave holes, too many would waste time
+    return wantedStepsS <= nStepsS && nStepsS <= SURFACE_CACHE_MAX_OVERSAMPLING * wantedStepsS &&
+           wantedStepsT <= nStepsT && nStepsT <= SURFACE_CACHE_MAX_OVERSAMPLING * wantedStepsT;
+    } // Covers()
+
+// evaluates the patch at the given resolution
+void SurfaceCache::Build(const std::vector<Point3> &controlPoints, unsigned long controlPointsVersion, int newNStepsS, int newNStepsT)
+    { // Build()
+    version = controlPointsVersion;
+    nStepsS = newNStepsS;
+    nStepsT = newNStepsT;
+    built = true;
+    nUpdates = 0;
+
+    sBasisTable.Resize(nStepsS);
+    tBasisTable.Resize(nStepsT);
+
+    long nSamples = (long)(nStepsS + 1) * (nStepsT + 1);
+    x.resize(nSamples);
+    y.resize(nSamples);
+    z.resize(nSamples);
+    shades.resize(nSamples);
+
+    Homogeneous4 netPoints[16];
+    for (int i = 0; i < 16; i++)
+        netPoints[i] = Homogeneous4(controlPoints[i]);
+
+    #pragma omp parallel for
+    for (int s = 0; s <= nStepsS; s++)
+        { // s parameter loop
+        float sParameter = (float)s / nStepsS;
+
+        // the row at this s is a cubic curve in t, as in the uncached renderer
+        const float *basisS = sBasisTable[s];
+        Homogeneous4 rowControlPoints[4];
+        for (int j = 0; j < 4; j++)
+            rowControlPoints[j] = bezierCombine(basisS, netPoints[j], netPoints[4 + j], netPoints[8 + j], netPoints[12 + j]);
+
+        long rowStart = (long)s * rowLength();
+        for (int t = 0; t <= nStepsT; t++)
+            { // t parameter loop
+            // the basis values sum to one so w stays 1 and can be dropped
+            Homogeneous4 point = bezierCombine(tBasisTable[t], rowControlPoints[0], rowControlPoints[1], rowControlPoints[2], rowControlPoints[3]);
+            x[rowStart + t] = point.x;
+            y[rowStart + t] = point.y;
+            z[rowStart + t] = point.z;
+            shades[rowStart + t] = FragmentShade::Surface(sParameter, (float)t / nStepsT);
+            } // t parameter loop
+        } // s parameter loop
+    } // Build()
+
+// moves the samples to follow the control points
+void SurfaceCache::ApplyChanges(const Vector3 deltas[16], unsigned long controlPointsVersion)
+    { // ApplyChanges()
+    version = controlPointsVersion;
+    nUpdates++;
+
+    // only the columns of the net that moved need a pass over the samples
+    int movedColumns[4], nMovedColumns = 0;
+    for (int j = 0; j < 4; j++)
+        for (int i = 0; i < 4; i++)
+            if (deltas[4 * i + j].x != 0.0f || deltas[4 * i + j].y != 0.0f || deltas[4 * i + j].z != 0.0f)
+                { // column moved
+                movedColumns[nMovedColumns++] = j;
+                break;
+                } // column moved
+
+    #pragma omp parallel for
+    for (int s = 0; s <= nStepsS; s++)
+        { // s parameter loop
+        float *rowX = &x[(long)s * rowLength()];
+        float *rowY = &y[(long)s * rowLength()];
+        float *rowZ = &z[(long)s * rowLength()];
+        const float *basisS = sBasisTable[s];
+
+        for (int k = 0; k < nMovedColumns; k++)
+            { // moved column
+            int j = movedColumns[k];
+
+            // how far the column's control point of this row's curve moves
+            float dx = 0.0f, dy = 0.0f, dz = 0.0f;
+            for (int i = 0; i < 4; i++)
+                { // control point in column
+                dx += basisS[i] * deltas[4 * i + j].x;
+                dy += basisS[i] * deltas[4 * i + j].y;
+                dz += basisS[i] * deltas[4 * i + j].z;
+                } // control point in column
+
+            // which moves each sample by that times the basis function in t
+            const float *basisT = tBasisTable.column(j);
+            #pragma omp simd
+            for (int t = 0; t <= nStepsT; t++)
+                { // t parameter loop
+                rowX[t] += dx * basisT[t];
+                rowY[t] += dy * basisT[t];
+                rowZ[t] += dz * basisT[t];
+                } // t parameter loop
+            } // moved column
+        } // s parameter loop
+    } // ApplyChanges()
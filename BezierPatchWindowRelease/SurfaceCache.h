@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  World space samples of the patch and their shades, kept
+//  between frames so a frame that only moves the camera
+//  just transforms and rasterises them
+//  
+///////////////////////////////////////////////////
+
+#ifndef SURFACE_CACHE_H
+#define SURFACE_CACHE_H
+
+#include <vector>
+
+#include "Point3.h"
+#include "Vector3.h"
+#include "FragmentShade.h"
+#include "BezierEvaluation.h"
+
+// the cache is only reused while it has no more than this many times
+// the samples wanted in each direction, so zooming out does not leave
+// it drawing far more samples than the adaptive policy asked for
+#define SURFACE_CACHE_MAX_OVERSAMPLING 2
+
+// the number of edits applied to the samples before they are evaluated afresh,
+// which bounds the round-off the updates can build up
+#define SURFACE_CACHE_MAX_UPDATES 256
+
+class SurfaceCache
+    { // class SurfaceCache
+    public:
+    // version of the control points the samples were built from
+    unsigned long version;
+
+    // number of intervals sampled in s and t, the samples are stored
+    // row by row with nStepsT + 1 samples in each of the nStepsS + 1 rows
+    int nStepsS, nStepsT;
+
+    // the world space samples as separate coordinate arrays for the SIMD transform
+    std::vector<float> x, y, z;
+
+    // what every sample is shaded from
+    std::vector<FragmentShade> shades;
+
+    // constructor, empty until built
+    SurfaceCache();
+
+    // whether the samples were built from this version of the control points
+    // at a resolution that can stand in for the one wanted
+    bool Fits(unsigned long controlPointsVersion, int wantedStepsS, int wantedStepsT) const;
+
+    // whether the resolution can stand in for the one wanted, whatever the version
+    bool Covers(int wantedStepsS, int wantedStepsT) const;
+
+    // whether the samples can still be brought up to date with ApplyChanges()
+    bool Updatable() const
+        { return built && nUpdates < SURFACE_CACHE_MAX_UPDATES; }
+
+    // evaluates the patch given by 16 control points (row major, s down the rows)
+    // at the given resolution and records the version it was built from
+    void Build(const std::vector<Point3> &controlPoints, unsigned long controlPointsVersion, int newNStepsS, int newNStepsT);
+
+    // moves the samples to follow the control points moving by the given offsets
+    // the patch is linear in each control point, so control point (i, j) moving by
+    // delta moves the sample at (s, t) by delta * B_i(s) * B_j(t)
+    // this costs a multiply-add per coordinate per sample for each column of the
+    // net that moved, against 16 for each to evaluate the patch again
+    void ApplyChanges(const Vector3 deltas[16], unsigned long controlPointsVersion);
+
+    // number of samples in a row
+    int rowLength() const
+        { return nStepsT + 1; }
+
+    private:
+    // Bernstein basis values at the cached resolution
+    BernsteinTable sBasisTable, tBasisTable;
+
+    // whether Build() has been called
+    bool built;
+
+    // number of times ApplyChanges() has been called since
+    int nUpdates;
+    }; // class SurfaceCache
+
+#endif
@@ -0,0 +1,174 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  Routines for choosing how finely to sample the patch
+//  from how large its control net projects on screen
+//  
+///////////////////////////////////////////////////
+
+#include <math.h>
+
+#include "Tessellation.h"
+
+// how many times over the speed bounds halve the net both ways, so on 4 x 4 pieces
+#define SPEED_SPLIT_LEVELS 2
+
+// splits the cubic with control points at p[0], p[stride], p[2 * stride], p[3 * stride] at its
+// midpoint with de Casteljau, writing the two halves to the same positions in first and second
+void splitCurve(const Homogeneous4 *p, int stride, Homogeneous4 *first, Homogeneous4 *second)
+    { // splitCurve()
+    Homogeneous4 p01 = 0.5f * (p[0] + p[stride]);
+    Homogeneous4 p12 = 0.5f * (p[stride] + p[2 * stride]);
+    Homogeneous4 p23 = 0.5f * (p[2 * stride] + p[3 * stride]);
+    Homogeneous4 p012 = 0.5f * (p01 + p12);
+    Homogeneous4 p123 = 0.5f * (p12 + p23);
+    Homogeneous4 middle = 0.5f * (p012 + p123);
+
+    first[0] = p[0];
+    first[stride] = p01;
+    first[2 * stride] = p012;
+    first[3 * stride] = middle;
+    second[0] = middle;
+    second[stride] = p123;
+    second[2 * stride] = p23;
+    second[3 * stride] = p[3 * stride];
+    } // splitCurve()
+
+// works out upper bounds on the screen space length of every iso-parameter curve
+bool projectedNetLengths(const Homogeneous4 clipControlPoints[16], float width, float height, float &lengthS, float &lengthT)
+    { // projectedNetLengths()
+    // Project the control points to the screen. With every w positive the projected patch
+    // is a rational Bezier patch with positive weights on these points, so it stays inside
+    // their convex hull and its curves are no longer than their control polygons
+    float screenX[16], screenY[16];
+    for (int i = 0; i < 16; i++)
+        { // control point
+        if (clipControlPoints[i].w <= 0.0f)
+            return false;
+        screenX[i] = (clipControlPoints[i].x / clipControlPoints[i].w + 1) / 2 * width;
+        screenY[i] = (clipControlPoints[i].y / clipControlPoints[i].w + 1) / 2 * height;
+        } // control point
+
+    // Every curve along t is a blend of the 4 rows of the net, so each edge of its control
+    // polygon is no longer than the longest matching edge over the rows. Summing those
+    // longest edges bounds all of the curves at once, and the same goes for s and columns
+    lengthS = 0.0f;
+    lengthT = 0.0f;
+    for (int edge = 0; edge < 3; edge++)
+        { // edge
+        float longestS = 0.0f, longestT = 0.0f;
+        for (int k = 0; k < 4; k++)
+            { // row or column
+            int sStart = edge * 4 + k, sEnd = sStart + 4;   // column k, rows edge & edge + 1
+            int tStart = k * 4 + edge, tEnd = tStart + 1;   // row k, columns edge & edge + 1
+            longestS = fmaxf(longestS, hypotf(screenX[sEnd] - screenX[sStart], screenY[sEnd] - screenY[sStart]));
+            longestT = fmaxf(longestT, hypotf(screenX[tEnd] - screenX[tStart], screenY[tEnd] - screenY[tStart]));
+            } // row or column
+        lengthS += longestS;
+        lengthT += longestT;
+        } // edge
+
+    return true;
+    } // projectedNetLengths()
+
+// bounds the speeds of one piece of the net, every w of which is positive, in its own parameters
+static void pieceSpeeds(const Homogeneous4 clipControlPoints[16], float width, float height, float &speedS, float &speedT)
+    { // pieceSpeeds()
+    // Project the control points to the screen, keeping the box around them and the smallest w
+    float screenX[16], screenY[16];
+    float minX = HUGE_VALF, maxX = -HUGE_VALF, minY = HUGE_VALF, maxY = -HUGE_VALF, minW = HUGE_VALF;
+    for (int i = 0; i < 16; i++)
+        { // control point
+        screenX[i] = (clipControlPoints[i].x / clipControlPoints[i].w + 1) / 2 * width;
+        screenY[i] = (clipControlPoints[i].y / clipControlPoints[i].w + 1) / 2 * height;
+        minX = fminf(minX, screenX[i]);
+        maxX = fmaxf(maxX, screenX[i]);
+        minY = fminf(minY, screenY[i]);
+        maxY = fmaxf(maxY, screenY[i]);
+        minW = fminf(minW, clipControlPoints[i].w);
+        } // control point
+
+    // A curve on screen is X / w, where X is its homogeneous position measured from the
+    // centre c of the box and both X and w are cubics, so its speed is (X' - (X / w - c) w') / w.
+    // The curve stays inside the box, so X / w - c is no longer than half the box's diagonal,
+    // and w is at least the smallest w of the net
+    float centreX = (minX + maxX) / 2, centreY = (minY + maxY) / 2;
+    float radius = hypotf(maxX - minX, maxY - minY) / 2;
+    float offsetX[16], offsetY[16];
+    for (int i = 0; i < 16; i++)
+        { // control point
+        offsetX[i] = (screenX[i] - centreX) * clipControlPoints[i].w;
+        offsetY[i] = (screenY[i] - centreY) * clipControlPoints[i].w;
+        } // control point
+
+    // The derivative of a cubic is 3 times a blend of its control polygon's edges, and every
+    // curve along t is a blend of the rows of the net, so X' and w' are no more than 3 times
+    // the longest matching edge over all the rows, and the same goes for s and columns.
+    // However unevenly the control points are spaced, that bounds the speed everywhere
+    float longestS = 0.0f, longestT = 0.0f, steepestS = 0.0f, steepestT = 0.0f;
+    for (int edge = 0; edge < 3; edge++)
+        for (int k = 0; k < 4; k++)
+            { // row or column
+            int sStart = edge * 4 + k, sEnd = sStart + 4;   // column k, rows edge & edge + 1
+            int tStart = k * 4 + edge, tEnd = tStart + 1;   // row k, columns edge & edge + 1
+            longestS = fmaxf(longestS, hypotf(offsetX[sEnd] - offsetX[sStart], offsetY[sEnd] - offsetY[sStart]));
+            longestT = fmaxf(longestT, hypotf(offsetX[tEnd] - offsetX[tStart], offsetY[tEnd] - offsetY[tStart]));
+            steepestS = fmaxf(steepestS, fabsf(clipControlPoints[sEnd].w - clipControlPoints[sStart].w));
+            steepestT = fmaxf(steepestT, fabsf(clipControlPoints[tEnd].w - clipControlPoints[tStart].w));
+            } // row or column
+
+    speedS = 3.0f * (longestS + radius * steepestS) / minW;
+    speedT = 3.0f * (longestT + radius * steepestT) / minW;
+    } // pieceSpeeds()
+
+// halves the piece both ways levels times over, raising the speeds to the bounds of the
+// smallest pieces, which are scale times as fast in the whole net's parameters
+static void splitSpeeds(const Homogeneous4 clipControlPoints[16], int levels, float scale, float width, float height, float &speedS, float &speedT)
+    { // splitSpeeds()
+    if (levels == 0)
+        { // smallest piece
+        float pieceS, pieceT;
+        pieceSpeeds(clipControlPoints, width, height, pieceS, pieceT);
+        speedS = fmaxf(speedS, scale * pieceS);
+        speedT = fmaxf(speedT, scale * pieceT);
+        return;
+        } // smallest piece
+
+    // split the columns at s = 1/2, then the rows of each half at t = 1/2
+    Homogeneous4 halves[2][16], quarters[4][16];
+    for (int j = 0; j < 4; j++)
+        splitCurve(clipControlPoints + j, 4, halves[0] + j, halves[1] + j);
+    for (int half = 0; half < 2; half++)
+        for (int i = 0; i < 4; i++)
+            splitCurve(halves[half] + i * 4, 1, quarters[half * 2] + i * 4, quarters[half * 2 + 1] + i * 4);
+
+    for (int quarter = 0; quarter < 4; quarter++)
+        splitSpeeds(quarters[quarter], levels - 1, scale * 2.0f, width, height, speedS, speedT);
+    } // splitSpeeds()
+
+// works out upper bounds on how many pixels every iso-parameter curve can move per unit of its parameter
+bool projectedNetSpeeds(const Homogeneous4 clipControlPoints[16], float width, float height, float &speedS, float &speedT)
+    { // projectedNetSpeeds()
+    for (int i = 0; i < 16; i++)
+        if (clipControlPoints[i].w <= 0.0f)
+            return false;
+
+    // The bound on the whole net can be several times the real speed under perspective,
+    // as it takes the fastest X' and w' and the slowest w from anywhere on the patch.
+    // On small pieces those are all close together, so it is nearly the real speed
+    speedS = 0.0f;
+    speedT = 0.0f;
+    splitSpeeds(clipControlPoints, SPEED_SPLIT_LEVELS, 1.0f, width, height, speedS, speedT);
+    return true;
+    } // projectedNetSpeeds()
+
+// number of intervals to sample a curve at, given the most pixels it moves per unit of its parameter
+int samplingSteps(float projectedSpeed, float samplesPerPixel)
+    { // samplingSteps()
+    float steps = ceilf(projectedSpeed * samplesPerPixel);
+    // compare as floats first, a huge speed would overflow an int
+    if (!(steps < MAX_SAMPLE_STEPS))
+        return MAX_SAMPLE_STEPS;
+    if (steps < MIN_SAMPLE_STEPS)
+        return MIN_SAMPLE_STEPS;
+    return (int)steps;
+    } // samplingSteps()
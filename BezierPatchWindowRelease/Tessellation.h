@@ -0,0 +1,39 @@
+//////////////////////////////////////////////////////////////////////
+//  
+//  Routines for choosing how finely to sample the patch
+//  from how large its control net projects on screen
+//  
+///////////////////////////////////////////////////
+
+#ifndef TESSELLATION_H
+#define TESSELLATION_H
+
+#include "Homogeneous4.h"
+
+// bounds on the number of intervals the patch is sampled at in each direction
+#define MIN_SAMPLE_STEPS 1
+#define MAX_SAMPLE_STEPS 2048
+
+// works out upper bounds on the screen space length of every iso-parameter curve
+// of the patch, from the control net in clip space (row major, s down the rows)
+// lengthS bounds the curves along s (fixed t), lengthT those along t (fixed s)
+// returns false if the net crosses the w = 0 plane, in which case it has no
+// finite projection and the lengths are not set
+bool projectedNetLengths(const Homogeneous4 clipControlPoints[16], float width, float height, float &lengthS, float &lengthT);
+
+// works out upper bounds on how many pixels every iso-parameter curve of the patch can move
+// on screen per unit of its parameter, from the control net in clip space as above
+// speedS bounds the curves along s, speedT those along t; samples evenly spaced in
+// the parameter are no further apart than the speed divided by the number of intervals
+// returns false if the net crosses the w = 0 plane, in which case the speeds are not set
+bool projectedNetSpeeds(const Homogeneous4 clipControlPoints[16], float width, float height, float &speedS, float &speedT);
+
+// splits the cubic with control points at p[0], p[stride], p[2 * stride], p[3 * stride] at its
+// midpoint with de Casteljau, writing the two halves to the same positions in first and second
+void splitCurve(const Homogeneous4 *p, int stride, Homogeneous4 *first, Homogeneous4 *second);
+
+// number of intervals to sample a curve at, given the most pixels it moves per unit of
+// its parameter, so its samples are no more than 1 / samplesPerPixel pixels apart
+int samplingSteps(float projectedSpeed, float samplesPerPixel);
+
+#endif
@@ -0,0 +1,180 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  A tile-based backend for the software renderer
+//  Primitives are not rasterized as they are drawn, but sorted into bins
+//  for the square screen tiles they overlap. At the end of the frame every
+//  tile is cleared, rasterized and depth tested by one thread on its own,
+//  so the threads never touch the same pixels and need no synchronisation
+//  Only the nearest fragment at each pixel of a tile is shaded, once the
+//  tile is done
+//
+///////////////////////////////////////////////////
+
+#include <math.h>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "TileBinner.h"
+
+// constructor
+TileBinner::TileBinner()
+    :
+    width(0),
+    height(0),
+    tilesX(0),
+    tilesY(0)
+    { // constructor
+    } // constructor
+
+// resizes the screen the tiles cover, emptying every bin
+void TileBinner::Resize(long Width, long Height)
+    { // Resize()
+    width = Width;
+    height = Height;
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    Clear();
+    } // Resize()
+
+// empties every bin, ready for a new frame
+void TileBinner::Clear()
+    { // Clear()
+#ifdef _OPENMP
+    threadBins.resize(omp_get_max_threads());
+#else
+    threadBins.resize(1);
+#endif
+
+    // clear rather than reallocate, so the bins keep their memory from frame to frame
+    for (ThreadBins &bins : threadBins)
+        { // thread
+        bins.triangles.clear();
+        bins.lines.clear();
+        bins.markers.clear();
+        bins.tiles.resize(tilesX * tilesY);
+        for (TileBin &bin : bins.tiles)
+            { // tile
+            bin.triangles.clear();
+            bin.lines.clear();
+            bin.markers.clear();
+            bin.fragments.clear();
+            } // tile
+        } // thread
+    } // Clear()
+
+// the bins of the calling thread
+ThreadBins &TileBinner::currentThreadBins()
+    { // currentThreadBins()
+#ifdef _OPENMP
+    return threadBins[omp_get_thread_num()];
+#else
+    return threadBins[0];
+#endif
+    } // currentThreadBins()
+
+// bins a primitive covering the given range of tiles (inclusive, already clamped)
+void TileBinner::binRange(std::vector<uint32_t> TileBin::*list, uint32_t index, ThreadBins &bins, long minTileX, long minTileY, long maxTileX, long maxTileY)
+    { // binRange()
+    for (long tileY = minTileY; tileY <= maxTileY; tileY++)
+        for (long tileX = minTileX; tileX <= maxTileX; tileX++)
+            (bins.tiles[tileY * tilesX + tileX].*list).push_back(index);
+    } // binRange()
+
+// bins a triangle, which must already be clipped to the view volume
+void TileBinner::AddTriangle(const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2)
+    { // AddTriangle()
+    // the tiles under the triangle's bounding box, which for the small triangles of the surface is usually one
+    float minX = fminf(v0.x, fminf(v1.x, v2.x)), maxX = fmaxf(v0.x, fmaxf(v1.x, v2.x));
+    float minY = fminf(v0.y, fminf(v1.y, v2.y)), maxY = fmaxf(v0.y, fmaxf(v1.y, v2.y));
+    if (!(maxX >= 0.0f && minX < width && maxY >= 0.0f && minY < height))
+        return;
+
+    long minTileX = std::max(0L, (long)minX / TILE_SIZE), maxTileX = std::min(tilesX - 1, (long)maxX / TILE_SIZE);
+    long minTileY = std::max(0L, (long)minY / TILE_SIZE), maxTileY = std::min(tilesY - 1, (long)maxY / TILE_SIZE);
+
+    ThreadBins &bins = currentThreadBins();
+    bins.triangles.push_back(BinnedTriangle{ { v0, v1, v2 } });
+    binRange(&TileBin::triangles, (uint32_t)(bins.triangles.size() - 1), bins, minTileX, minTileY, maxTileX, maxTileY);
+    } // AddTriangle()
+
+// bins a line between two screen space points, into only the tiles it passes through
+void TileBinner::AddLine(const Point3 &start, const Point3 &end, FragmentShade shade)
+    { // AddLine()
+    float dx = end.x - start.x, dy = end.y - start.y;
+    if (dx != dx || dy != dy)
+        return;
+
+    // walk the line one tile at a time along its major axis, working out the pixels it
+    // covers at each end of that stretch exactly as rasterizeLine() does, so every tile
+    // it writes to is binned and long diagonal lines are not binned into every tile
+    bool xMajor = fabsf(dx) >= fabsf(dy);
+    float majorStart = xMajor ? start.x : start.y, majorEnd = xMajor ? end.x : end.y;
+    float majorLength = xMajor ? dx : dy;
+    long majorSize = xMajor ? width : height, minorSize = xMajor ? height : width;
+    float minorStart = xMajor ? start.y : start.x, minorLength = xMajor ? dy : dx;
+
+    long first = (long)fmaxf(0.0f, ceilf(fminf(majorStart, majorEnd) - 0.5f));
+    long last = (long)fminf((float)majorSize - 1.0f, floorf(fmaxf(majorStart, majorEnd) - 0.5f));
+    if (first > last)
+        return;
+
+    ThreadBins &bins = currentThreadBins();
+    bins.lines.push_back(BinnedLine{ start, end, shade });
+    uint32_t index = (uint32_t)(bins.lines.size() - 1);
+
+    auto minorAt = [&](long major)
+        { // minorAt()
+        float fraction = majorLength != 0.0f ? (major + 0.5f - majorStart) / majorLength : 0.0f;
+        return (long)floorf(minorStart + minorLength * fraction);
+        }; // minorAt()
+
+    for (long majorTile = first / TILE_SIZE; majorTile <= last / TILE_SIZE; majorTile++)
+        { // stretch
+        long stretchFirst = std::max(first, majorTile * TILE_SIZE), stretchLast = std::min(last, majorTile * TILE_SIZE + TILE_SIZE - 1);
+        long minorFirst = minorAt(stretchFirst), minorLast = minorAt(stretchLast);
+        long minorLow = std::max(0L, std::min(minorFirst, minorLast)), minorHigh = std::min(minorSize - 1, std::max(minorFirst, minorLast));
+        if (minorLow > minorHigh)
+            continue;
+
+        if (xMajor)
+            binRange(&TileBin::lines, index, bins, majorTile, minorLow / TILE_SIZE, majorTile, minorHigh / TILE_SIZE);
+        else
+            binRange(&TileBin::lines, index, bins, minorLow / TILE_SIZE, majorTile, minorHigh / TILE_SIZE, majorTile);
+        } // stretch
+    } // AddLine()
+
+// bins a round marker stamped around a screen space point
+void TileBinner::AddMarker(const Point3 &centre, const MarkerStamp &stamp, FragmentShade shade)
+    { // AddMarker()
+    float minX = floorf(centre.x) - stamp.radius, maxX = floorf(centre.x) + stamp.radius;
+    float minY = floorf(centre.y) - stamp.radius, maxY = floorf(centre.y) + stamp.radius;
+    if (maxX < 0.0f || minX >= width || maxY < 0.0f || minY >= height)
+        return;
+
+    long minTileX = std::max(0L, (long)minX / TILE_SIZE), maxTileX = std::min(tilesX - 1, (long)maxX / TILE_SIZE);
+    long minTileY = std::max(0L, (long)minY / TILE_SIZE), maxTileY = std::min(tilesY - 1, (long)maxY / TILE_SIZE);
+
+    ThreadBins &bins = currentThreadBins();
+    bins.markers.push_back(BinnedMarker{ centre, &stamp, shade });
+    binRange(&TileBin::markers, (uint32_t)(bins.markers.size() - 1), bins, minTileX, minTileY, maxTileX, maxTileY);
+    } // AddMarker()
+
+// bins a single fragment, ignoring the (-1, -1, -1) clipped point
+void TileBinner::AddFragment(const Point3 &point, FragmentShade shade)
+    { // AddFragment()
+    if (point.x < 0 || point.x >= width || point.y < 0 || point.y >= height)
+        return;
+
+    long tile = ((long)point.y / TILE_SIZE) * tilesX + (long)point.x / TILE_SIZE;
+    currentThreadBins().tiles[tile].fragments.push_back(BinnedFragment{ point, shade });
+    } // AddFragment()
+
+// the pixels a tile covers, clamped to the screen
+PixelRect TileBinner::TileRect(long tileX, long tileY) const
+    { // TileRect()
+    return PixelRect{ tileX * TILE_SIZE, tileY * TILE_SIZE,
+                      std::min(width, (tileX + 1) * TILE_SIZE), std::min(height, (tileY + 1) * TILE_SIZE) };
+    } // TileRect()
@@ -0,0 +1,200 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  A tile-based backend for the software renderer
+//  Primitives are not rasterized as they are drawn, but sorted into bins
+//  for the square screen tiles they overlap. At the end of the frame every
+//  tile is cleared, rasterized and depth tested by one thread on its own,
+//  so the threads never touch the same pixels and need no synchronisation
+//  Only the nearest fragment at each pixel of a tile is shaded, once the
+//  tile is done
+//
+//  Any number of OpenMP threads may add primitives at once, each into
+//  its own set of bins
+//
+///////////////////////////////////////////////////
+
+#ifndef TILEBINNER_H
+#define TILEBINNER_H
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+#include "Point3.h"
+#include "FragmentShade.h"
+#include "RGBAImage.h"
+#include "DepthBuffer.h"
+#include "Rasterizer.h"
+
+// width and height of a screen tile in pixels
+#define TILE_SIZE 64
+
+// a filled triangle of the surface, its fragments shaded from their interpolated (s, t)
+struct BinnedTriangle
+    { // struct BinnedTriangle
+    RasterVertex vertices[3];
+    }; // struct BinnedTriangle
+
+// a line between two screen space points
+struct BinnedLine
+    { // struct BinnedLine
+    Point3 start, end;
+    FragmentShade shade;
+    }; // struct BinnedLine
+
+// a round marker around a screen space point, stamped from a stamp that outlives the frame
+struct BinnedMarker
+    { // struct BinnedMarker
+    Point3 centre;
+    const MarkerStamp *stamp;
+    FragmentShade shade;
+    }; // struct BinnedMarker
+
+// a single fragment, already in screen space
+struct BinnedFragment
+    { // struct BinnedFragment
+    Point3 point;
+    FragmentShade shade;
+    }; // struct BinnedFragment
+
+// what one thread has binned into one tile, primitives by their index in that thread's lists
+struct TileBin
+    { // struct TileBin
+    std::vector<uint32_t> triangles, lines, markers;
+    std::vector<BinnedFragment> fragments;
+    }; // struct TileBin
+
+// everything one thread has binned this frame
+struct ThreadBins
+    { // struct ThreadBins
+    std::vector<BinnedTriangle> triangles;
+    std::vector<BinnedLine> lines;
+    std::vector<BinnedMarker> markers;
+    std::vector<TileBin> tiles;
+    }; // struct ThreadBins
+
+// the class itself
+class TileBinner
+    { // class TileBinner
+    public:
+    // dimensions of the screen, and how many tiles across and down it
+    long width, height;
+    long tilesX, tilesY;
+
+    // one set of bins per thread, kept between frames to reuse the memory
+    std::vector<ThreadBins> threadBins;
+
+    // constructor
+    TileBinner();
+
+    // resizes the screen the tiles cover, emptying every bin
+    void Resize(long Width, long Height);
+
+    // empties every bin, ready for a new frame
+    void Clear();
+
+    // bins a triangle, which must already be clipped to the view volume
+    void AddTriangle(const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2);
+
+    // bins a line between two screen space points, into only the tiles it passes through
+    void AddLine(const Point3 &start, const Point3 &end, FragmentShade shade);
+
+    // bins a round marker stamped around a screen space point
+    void AddMarker(const Point3 &centre, const MarkerStamp &stamp, FragmentShade shade);
+
+    // bins a single fragment, ignoring the (-1, -1, -1) clipped point
+    void AddFragment(const Point3 &point, FragmentShade shade);
+
+    // the pixels a tile covers, clamped to the screen
+    PixelRect TileRect(long tileX, long tileY) const;
+
+    // clears every tile of the depth buffer (which must be the same size as the tiles) and
+    // depth tests everything binned into it, one tile per thread, then colours each pixel
+    // of the tile in the image with shade(FragmentShade) from the nearest fragment there,
+    // or from clearShade where there is none
+    // triangles are filled by the triangle kernel at the given level
+    template <typename Shader>
+    void Resolve(KernelLevel level, RGBAImage &image, DepthBuffer &depthBuffer, FragmentShade clearShade, const Shader &shade);
+
+    private:
+    // the bins of the calling thread
+    ThreadBins &currentThreadBins();
+
+    // bins a primitive covering the given range of tiles (inclusive, already clamped)
+    void binRange(std::vector<uint32_t> TileBin::*list, uint32_t index, ThreadBins &bins, long minTileX, long minTileY, long maxTileX, long maxTileY);
+
+    }; // class TileBinner
+
+// clears every tile and depth tests everything binned into it, one tile per thread,
+// then shades the nearest fragment at each pixel
+template <typename Shader>
+void TileBinner::Resolve(KernelLevel level, RGBAImage &image, DepthBuffer &depthBuffer, FragmentShade clearShade, const Shader &shade)
+    { // Resolve()
+    long nTiles = tilesX * tilesY;
+
+    #pragma omp parallel
+    { // parallel region
+    // what each pixel of the tile is to be shaded from, kept by the thread from tile to tile
+    std::vector<FragmentShade> tileShades(TILE_SIZE * TILE_SIZE);
+
+    // tiles differ a lot in how much is in them, so hand them out one at a time
+    #pragma omp for schedule(dynamic, 1)
+    for (long tile = 0; tile < nTiles; tile++)
+        { // tile
+        PixelRect rect = TileRect(tile % tilesX, tile / tilesX);
+
+        // clear this tile's slice of the depth buffer, a row at a time, and its shades
+        for (long y = rect.minY; y < rect.maxY; y++)
+            std::fill(depthBuffer.block + y * width + rect.minX, depthBuffer.block + y * width + rect.maxX, std::numeric_limits<float>::max());
+        std::fill(tileShades.begin(), tileShades.end(), clearShade);
+
+        // nothing outside this tile is written, so plain depth tests are safe
+        auto writePixel = [&](long x, long y, float z, FragmentShade fragmentShade)
+            { // writePixel()
+            long pixel = y * width + x;
+            if (z < depthBuffer.block[pixel])
+                { // nearer
+                depthBuffer.block[pixel] = z;
+                tileShades[(y - rect.minY) * TILE_SIZE + (x - rect.minX)] = fragmentShade;
+                } // nearer
+            }; // writePixel()
+
+        for (const ThreadBins &bins : threadBins)
+            { // thread
+            const TileBin &bin = bins.tiles[tile];
+
+            for (uint32_t index : bin.lines)
+                { // line
+                const BinnedLine &line = bins.lines[index];
+                auto writeLine = [&](float x, float y, float z) { writePixel((long)x, (long)y, z, line.shade); };
+                rasterizeLine(line.start, line.end, rect, writeLine);
+                } // line
+
+            for (uint32_t index : bin.markers)
+                { // marker
+                const BinnedMarker &marker = bins.markers[index];
+                auto writeMarker = [&](float x, float y, float z) { writePixel((long)x, (long)y, z, marker.shade); };
+                rasterizeMarker(marker.centre, *marker.stamp, rect, writeMarker);
+                } // marker
+
+            auto writeSurface = [&](float x, float y, float z, float s, float t) { writePixel((long)x, (long)y, z, FragmentShade::Surface(s, t)); };
+            for (uint32_t index : bin.triangles)
+                { // triangle
+                const BinnedTriangle &triangle = bins.triangles[index];
+                rasterizeTriangle(level, triangle.vertices[0], triangle.vertices[1], triangle.vertices[2], rect, writeSurface);
+                } // triangle
+
+            for (const BinnedFragment &fragment : bin.fragments)
+                writePixel((long)fragment.point.x, (long)fragment.point.y, fragment.point.z, fragment.shade);
+            } // thread
+
+        // shade only what survived, straight into the image
+        for (long y = rect.minY; y < rect.maxY; y++)
+            for (long x = rect.minX; x < rect.maxX; x++)
+                image.block[y * width + x] = shade(tileShades[(y - rect.minY) * TILE_SIZE + (x - rect.minX)]);
+        } // tile
+    } // parallel region
+    } // Resolve()
+
+#endif
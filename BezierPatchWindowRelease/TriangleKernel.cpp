@@ -0,0 +1,254 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  SIMD kernel that finds the covered pixels along a pair of rows of a
+//  triangle and interpolates their depth and (s, t) parameters
+//  Tests blocks of 4 x 2 pixels at a time against the edge functions with
+//  AVX2 or 2 x 2 with SSE, picked at runtime from what the CPU supports
+//
+///////////////////////////////////////////////////
+
+#include "TriangleKernel.h"
+
+// SIMD paths are only built for x86 with GCC/Clang, as in PatchKernel.cpp
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TRIANGLE_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// plain C++ version, one pixel at a time
+static int fillTriangleRowScalar(const TriangleSetup &setup, long y, int *xOut, float *zOut, float *sOut, float *tOut)
+    { // fillTriangleRowScalar()
+    long rowOffset = y - setup.minY;
+    long long edge[3];
+    for (int i = 0; i < 3; i++)
+        edge[i] = setup.edgeStart[i] + setup.edgeStepY[i] * rowOffset + setup.edgeBias[i];
+
+    // the planes at the start of the row
+    float z = setup.z + setup.zStepY * (float)rowOffset;
+    float invW = setup.invW + setup.invWStepY * (float)rowOffset;
+    float sOverW = setup.sOverW + setup.sOverWStepY * (float)rowOffset;
+    float tOverW = setup.tOverW + setup.tOverWStepY * (float)rowOffset;
+
+    int n = 0;
+    for (long x = setup.minX; x <= setup.maxX; x++)
+        { // pixel
+        if ((edge[0] | edge[1] | edge[2]) >= 0)
+            { // covered
+            float offset = (float)(x - setup.minX);
+            float pixelZ = z + setup.zStepX * offset;
+            if (pixelZ >= -1.0f && pixelZ <= 1.0f)
+                { // in depth
+                float pixelW = 1.0f / (invW + setup.invWStepX * offset);
+                xOut[n] = (int)x;
+                zOut[n] = pixelZ;
+                sOut[n] = (sOverW + setup.sOverWStepX * offset) * pixelW;
+                tOut[n] = (tOverW + setup.tOverWStepX * offset) * pixelW;
+                n++;
+                } // in depth
+            } // covered
+        for (int i = 0; i < 3; i++)
+            edge[i] += setup.edgeStepX[i];
+        } // pixel
+    return n;
+    } // fillTriangleRowScalar()
+
+// both rows a pixel at a time
+static void fillTriangleRowsScalar(const TriangleSetup &setup, long y, int *x, float *z, float *s, float *t, int nCovered[2])
+    { // fillTriangleRowsScalar()
+    nCovered[0] = fillTriangleRowScalar(setup, y, x, z, s, t);
+    nCovered[1] = y < setup.maxY ? fillTriangleRowScalar(setup, y + 1, x + TRIANGLE_KERNEL_MAX_ROW, z + TRIANGLE_KERNEL_MAX_ROW, s + TRIANGLE_KERNEL_MAX_ROW, t + TRIANGLE_KERNEL_MAX_ROW) : 0;
+    } // fillTriangleRowsScalar()
+
+#ifdef TRIANGLE_KERNEL_X86
+
+// copies the covered lanes of one row of a block to the end of that row's output
+static inline void packRow(int covered, long x, const float *zs, const float *ss, const float *ts, int *xOut, float *zOut, float *sOut, float *tOut, int &n)
+    { // packRow()
+    for (; covered != 0; covered &= covered - 1)
+        { // covered pixel
+        int k = __builtin_ctz(covered);
+        xOut[n] = (int)x + k;
+        zOut[n] = zs[k];
+        sOut[n] = ss[k];
+        tOut[n] = ts[k];
+        n++;
+        } // covered pixel
+    } // packRow()
+
+// SSE version, blocks of 2 x 2 pixels: lanes 0 and 1 are in row y, 2 and 3 the same pixels in row y + 1
+// the edge functions of a small triangle fit in 32 bits, so they are stepped as integers
+__attribute__((target("sse2")))
+static void fillTriangleRowsSSE(const TriangleSetup &setup, long y, int *xOut, float *zOut, float *sOut, float *tOut, int nCovered[2])
+    { // fillTriangleRowsSSE()
+    long rowOffset = y - setup.minY;
+
+    // each edge function at the first block, and how much it moves from one block to the next
+    __m128i edge[3], edgeStep[3];
+    for (int i = 0; i < 3; i++)
+        { // edge
+        int start = (int)(setup.edgeStart[i] + setup.edgeStepY[i] * rowOffset + setup.edgeBias[i]);
+        int below = start + (int)setup.edgeStepY[i];
+        int step = (int)setup.edgeStepX[i];
+        edge[i] = _mm_setr_epi32(start, start + step, below, below + step);
+        edgeStep[i] = _mm_set1_epi32(2 * step);
+        } // edge
+
+    // the planes at the start of each row, worked out as the scalar code does, and their steps
+    float z0 = setup.z + setup.zStepY * (float)rowOffset, z1 = setup.z + setup.zStepY * (float)(rowOffset + 1);
+    float invW0 = setup.invW + setup.invWStepY * (float)rowOffset, invW1 = setup.invW + setup.invWStepY * (float)(rowOffset + 1);
+    float sOverW0 = setup.sOverW + setup.sOverWStepY * (float)rowOffset, sOverW1 = setup.sOverW + setup.sOverWStepY * (float)(rowOffset + 1);
+    float tOverW0 = setup.tOverW + setup.tOverWStepY * (float)rowOffset, tOverW1 = setup.tOverW + setup.tOverWStepY * (float)(rowOffset + 1);
+    __m128 z = _mm_setr_ps(z0, z0, z1, z1), zStepX = _mm_set1_ps(setup.zStepX);
+    __m128 invW = _mm_setr_ps(invW0, invW0, invW1, invW1), invWStepX = _mm_set1_ps(setup.invWStepX);
+    __m128 sOverW = _mm_setr_ps(sOverW0, sOverW0, sOverW1, sOverW1), sOverWStepX = _mm_set1_ps(setup.sOverWStepX);
+    __m128 tOverW = _mm_setr_ps(tOverW0, tOverW0, tOverW1, tOverW1), tOverWStepX = _mm_set1_ps(setup.tOverWStepX);
+    const __m128 minusOne = _mm_set1_ps(-1.0f), one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+    const __m128i column = _mm_setr_epi32(0, 1, 0, 1);
+    // the second row's lanes are left out past the bottom of the triangle
+    int belowMask = y < setup.maxY ? -1 : 0;
+    const __m128i inRows = _mm_setr_epi32(-1, -1, belowMask, belowMask);
+
+    // pixel offsets from the start of the triangle's box, which are small integers so exact as floats
+    __m128 offset = _mm_cvtepi32_ps(column);
+
+    nCovered[0] = nCovered[1] = 0;
+    for (long x = setup.minX; x <= setup.maxX; x += 2)
+        { // 2 x 2 pixels
+        // covered where no edge function is negative, so their OR has no sign bit,
+        // and not past the end of the rows
+        __m128i outside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(edge[0], edge[1]), edge[2]), 31);
+        __m128i inBlock = _mm_and_si128(_mm_cmplt_epi32(column, _mm_set1_epi32((int)(setup.maxX - x + 1))), inRows);
+        int covered = _mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(outside, inBlock)));
+
+        if (covered)
+            { // some covered
+            __m128 pixelZ = _mm_add_ps(z, _mm_mul_ps(zStepX, offset));
+            covered &= _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(pixelZ, minusOne), _mm_cmple_ps(pixelZ, one)));
+
+            // one divide for both parameters
+            __m128 pixelW = _mm_div_ps(one, _mm_add_ps(invW, _mm_mul_ps(invWStepX, offset)));
+            __m128 s = _mm_mul_ps(_mm_add_ps(sOverW, _mm_mul_ps(sOverWStepX, offset)), pixelW);
+            __m128 t = _mm_mul_ps(_mm_add_ps(tOverW, _mm_mul_ps(tOverWStepX, offset)), pixelW);
+
+            // pack each row's covered pixels together in its output
+            float zs[4], ss[4], ts[4];
+            _mm_storeu_ps(zs, pixelZ);
+            _mm_storeu_ps(ss, s);
+            _mm_storeu_ps(ts, t);
+            packRow(covered & 3, x, zs, ss, ts, xOut, zOut, sOut, tOut, nCovered[0]);
+            packRow(covered >> 2, x, zs + 2, ss + 2, ts + 2, xOut + TRIANGLE_KERNEL_MAX_ROW, zOut + TRIANGLE_KERNEL_MAX_ROW,
+                    sOut + TRIANGLE_KERNEL_MAX_ROW, tOut + TRIANGLE_KERNEL_MAX_ROW, nCovered[1]);
+            } // some covered
+
+        for (int i = 0; i < 3; i++)
+            edge[i] = _mm_add_epi32(edge[i], edgeStep[i]);
+        offset = _mm_add_ps(offset, two);
+        } // 2 x 2 pixels
+    } // fillTriangleRowsSSE()
+
+// for each mask of covered lanes in a row of 4, the covered lanes in order, then the rest
+static const int leftPackLanes[16][4] = {
+    { 0, 1, 2, 3 }, { 0, 1, 2, 3 }, { 1, 0, 2, 3 }, { 0, 1, 2, 3 },
+    { 2, 0, 1, 3 }, { 0, 2, 1, 3 }, { 1, 2, 0, 3 }, { 0, 1, 2, 3 },
+    { 3, 0, 1, 2 }, { 0, 3, 1, 2 }, { 1, 3, 0, 2 }, { 0, 1, 3, 2 },
+    { 2, 3, 0, 1 }, { 0, 2, 3, 1 }, { 1, 2, 3, 0 }, { 0, 1, 2, 3 } };
+
+// copies the covered lanes of one row of a 4 x 2 block to the end of that row's output,
+// shuffling them to the front and storing all 4 lanes, so the outputs need 3 spare values past the row
+__attribute__((target("avx2")))
+static inline void packRowAVX2(int covered, long x, __m128 z, __m128 s, __m128 t, int *xOut, float *zOut, float *sOut, float *tOut, int &n)
+    { // packRowAVX2()
+    if (covered == 0)
+        return;
+    // the lane numbers are also the pixels' offsets from x
+    __m128i lanes = _mm_loadu_si128((const __m128i *)leftPackLanes[covered]);
+    _mm_storeu_si128((__m128i *)(xOut + n), _mm_add_epi32(_mm_set1_epi32((int)x), lanes));
+    _mm_storeu_ps(zOut + n, _mm_permutevar_ps(z, lanes));
+    _mm_storeu_ps(sOut + n, _mm_permutevar_ps(s, lanes));
+    _mm_storeu_ps(tOut + n, _mm_permutevar_ps(t, lanes));
+    n += __builtin_popcount(covered);
+    } // packRowAVX2()
+
+// AVX2 version, blocks of 4 x 2 pixels: lanes 0 to 3 are in row y, 4 to 7 the same pixels in row y + 1,
+// otherwise identical to the SSE one
+__attribute__((target("avx2")))
+static void fillTriangleRowsAVX2(const TriangleSetup &setup, long y, int *xOut, float *zOut, float *sOut, float *tOut, int nCovered[2])
+    { // fillTriangleRowsAVX2()
+    long rowOffset = y - setup.minY;
+
+    // which row of the block and which pixel along it each lane is
+    const __m256i column = _mm256_setr_epi32(0, 1, 2, 3, 0, 1, 2, 3);
+    const __m256i lowerRow = _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1);
+
+    // each edge function at the first block, and how much it moves from one block to the next
+    __m256i edge[3], edgeStep[3];
+    for (int i = 0; i < 3; i++)
+        { // edge
+        __m256i start = _mm256_set1_epi32((int)(setup.edgeStart[i] + setup.edgeStepY[i] * rowOffset + setup.edgeBias[i]));
+        __m256i step = _mm256_set1_epi32((int)setup.edgeStepX[i]);
+        __m256i below = _mm256_and_si256(_mm256_set1_epi32((int)setup.edgeStepY[i]), lowerRow);
+        edge[i] = _mm256_add_epi32(_mm256_add_epi32(start, below), _mm256_mullo_epi32(step, column));
+        edgeStep[i] = _mm256_slli_epi32(step, 2);
+        } // edge
+
+    // the planes at the start of each row, worked out as the scalar code does, and their steps
+    // (the row offsets are small integers, so adding one to them as floats is exact)
+    __m256 rows = _mm256_add_ps(_mm256_set1_ps((float)rowOffset), _mm256_setr_ps(0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f));
+    __m256 z = _mm256_add_ps(_mm256_set1_ps(setup.z), _mm256_mul_ps(_mm256_set1_ps(setup.zStepY), rows)), zStepX = _mm256_set1_ps(setup.zStepX);
+    __m256 invW = _mm256_add_ps(_mm256_set1_ps(setup.invW), _mm256_mul_ps(_mm256_set1_ps(setup.invWStepY), rows)), invWStepX = _mm256_set1_ps(setup.invWStepX);
+    __m256 sOverW = _mm256_add_ps(_mm256_set1_ps(setup.sOverW), _mm256_mul_ps(_mm256_set1_ps(setup.sOverWStepY), rows)), sOverWStepX = _mm256_set1_ps(setup.sOverWStepX);
+    __m256 tOverW = _mm256_add_ps(_mm256_set1_ps(setup.tOverW), _mm256_mul_ps(_mm256_set1_ps(setup.tOverWStepY), rows)), tOverWStepX = _mm256_set1_ps(setup.tOverWStepX);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f), one = _mm256_set1_ps(1.0f), four = _mm256_set1_ps(4.0f);
+    // the second row's lanes are left out past the bottom of the triangle
+    const __m256i inRows = y < setup.maxY ? _mm256_set1_epi32(-1) : _mm256_xor_si256(lowerRow, _mm256_set1_epi32(-1));
+
+    // pixel offsets from the start of the triangle's box, which are small integers so exact as floats
+    __m256 offset = _mm256_cvtepi32_ps(column);
+
+    nCovered[0] = nCovered[1] = 0;
+    for (long x = setup.minX; x <= setup.maxX; x += 4)
+        { // 4 x 2 pixels
+        // covered where no edge function is negative, so their OR has no sign bit,
+        // and not past the end of the rows
+        __m256i outside = _mm256_srai_epi32(_mm256_or_si256(_mm256_or_si256(edge[0], edge[1]), edge[2]), 31);
+        __m256i inBlock = _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32((int)(setup.maxX - x + 1)), column), inRows);
+        int covered = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(outside, inBlock)));
+
+        if (covered)
+            { // some covered
+            __m256 pixelZ = _mm256_add_ps(z, _mm256_mul_ps(zStepX, offset));
+            covered &= _mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(pixelZ, minusOne, _CMP_GE_OQ), _mm256_cmp_ps(pixelZ, one, _CMP_LE_OQ)));
+
+            // one divide for both parameters
+            __m256 pixelW = _mm256_div_ps(one, _mm256_add_ps(invW, _mm256_mul_ps(invWStepX, offset)));
+            __m256 s = _mm256_mul_ps(_mm256_add_ps(sOverW, _mm256_mul_ps(sOverWStepX, offset)), pixelW);
+            __m256 t = _mm256_mul_ps(_mm256_add_ps(tOverW, _mm256_mul_ps(tOverWStepX, offset)), pixelW);
+
+            // pack each row's covered pixels together in its output
+            packRowAVX2(covered & 15, x, _mm256_castps256_ps128(pixelZ), _mm256_castps256_ps128(s), _mm256_castps256_ps128(t),
+                        xOut, zOut, sOut, tOut, nCovered[0]);
+            packRowAVX2(covered >> 4, x, _mm256_extractf128_ps(pixelZ, 1), _mm256_extractf128_ps(s, 1), _mm256_extractf128_ps(t, 1),
+                        xOut + TRIANGLE_KERNEL_MAX_ROW, zOut + TRIANGLE_KERNEL_MAX_ROW, sOut + TRIANGLE_KERNEL_MAX_ROW, tOut + TRIANGLE_KERNEL_MAX_ROW, nCovered[1]);
+            } // some covered
+
+        for (int i = 0; i < 3; i++)
+            edge[i] = _mm256_add_epi32(edge[i], edgeStep[i]);
+        offset = _mm256_add_ps(offset, four);
+        } // 4 x 2 pixels
+    } // fillTriangleRowsAVX2()
+
+#endif
+
+// finds the covered pixels in a pair of rows of a small triangle
+void fillTriangleRows(KernelLevel level, const TriangleSetup &setup, long y, int *x, float *z, float *s, float *t, int nCovered[2])
+    { // fillTriangleRows()
+#ifdef TRIANGLE_KERNEL_X86
+    if (level == KERNEL_AVX2)
+        return fillTriangleRowsAVX2(setup, y, x, z, s, t, nCovered);
+    if (level >= KERNEL_SSE)
+        return fillTriangleRowsSSE(setup, y, x, z, s, t, nCovered);
+#else
+    (void)level;
+#endif
+    fillTriangleRowsScalar(setup, y, x, z, s, t, nCovered);
+    } // fillTriangleRows()
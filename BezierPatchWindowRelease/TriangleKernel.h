@@ -0,0 +1,52 @@
+//////////////////////////////////////////////////////////////////////
+//
+//  SIMD kernel that finds the covered pixels along a pair of rows of a
+//  triangle and interpolates their depth and (s, t) parameters
+//  Tests blocks of 4 x 2 pixels at a time against the edge functions with
+//  AVX2 or 2 x 2 with SSE, picked at runtime from what the CPU supports,
+//  so the few pixels across a small triangle still fill the vector
+//
+///////////////////////////////////////////////////
+
+#ifndef TRIANGLE_KERNEL_H
+#define TRIANGLE_KERNEL_H
+
+#include "PatchKernel.h"
+
+// largest triangle, in pixels across its vertices either way, the kernel can fill:
+// its edge functions then fit in 32 bits at every pixel the kernel visits
+#define TRIANGLE_KERNEL_MAX_SIZE 112
+// so the most fragments one row of it can give, with room for a partly used last block
+#define TRIANGLE_KERNEL_MAX_ROW (TRIANGLE_KERNEL_MAX_SIZE + 4)
+
+// a triangle in screen space, set up for filling
+struct TriangleSetup
+    { // struct TriangleSetup
+    // the pixels to visit, inclusive
+    long minX, minY, maxX, maxY;
+
+    // edge functions at the centre of pixel (minX, minY), in sub-pixel units and exact,
+    // with their steps per pixel across and down, edge i being opposite vertex i
+    // a pixel is covered if every edge function plus its bias is at least zero
+    // (the bias is -1 on edges that are not top-left, so pixel centres on them are left out)
+    long long edgeStart[3], edgeStepX[3], edgeStepY[3], edgeBias[3];
+
+    // depth, 1 / w, s / w and t / w are linear in screen space, so each is kept
+    // as its value at the centre of pixel (minX, minY) and its change per pixel across and down
+    float z, zStepX, zStepY;
+    float invW, invWStepX, invWStepY;
+    float sOverW, sOverWStepX, sOverWStepY;
+    float tOverW, tOverWStepX, tOverWStepY;
+
+    // whether the triangle is small enough for the SIMD kernel
+    bool small;
+    }; // struct TriangleSetup
+
+// finds the covered pixels in rows y and y + 1 of a small triangle whose depth is inside the view
+// volume, writing their x, depth and (s, t) to the arrays, which must hold 2 * TRIANGLE_KERNEL_MAX_ROW
+// values: row y's from the start and row y + 1's from TRIANGLE_KERNEL_MAX_ROW on, nCovered[0] and
+// nCovered[1] of them (row y + 1 is left empty if it is past the bottom of the triangle)
+// every level does the same operations in the same order, so they give exactly the same fragments
+void fillTriangleRows(KernelLevel level, const TriangleSetup &setup, long y, int *x, float *z, float *s, float *t, int nCovered[2]);
+
+#endif
@@ -0,0 +1,1215 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include "../BezierPatchWindowRelease/Homogeneous4.h"
+#include "../BezierPatchWindowRelease/BezierEvaluation.h"
+#include "../BezierPatchWindowRelease/PatchKernel.h"
+#include "../BezierPatchWindowRelease/Tessellation.h"
+#include "../BezierPatchWindowRelease/Subdivision.h"
+#include "../BezierPatchWindowRelease/Rasterizer.h"
+#include "../BezierPatchWindowRelease/SurfaceCache.h"
+#include "../BezierPatchWindowRelease/Clipping.h"
+#include "../BezierPatchWindowRelease/TileBinner.h"
+#include "../BezierPatchWindowRelease/FragmentSorter.h"
+#include "../BezierPatchWindowRelease/FragmentShade.h"
+#include "../BezierPatchWindowRelease/FragmentArena.h"
+#include "../BezierPatchWindowRelease/PatchRenderer.h"
+#include "../BezierPatchWindowRelease/FrameTimer.h"
+#include "../BezierPatchWindowRelease/FrameTracer.h"
+
+// checks that stepping a curve with forward differences gives the
+// same samples as evaluating the Bernstein polynomials at each one
+bool testForwardDifferences(const Homogeneous4 controlPoints[4], int nSteps) {
+    BezierForwardDifferencer curve(controlPoints[0], controlPoints[1], controlPoints[2], controlPoints[3], nSteps);
+
+    float worstError = 0.0f;
+    for (int step = 0; step <= nSteps; step++) {
+        Homogeneous4 stepped = curve.next();
+        Homogeneous4 evaluated = bezierPoint((float)step / nSteps, controlPoints[0], controlPoints[1], controlPoints[2], controlPoints[3]);
+        for (int i = 0; i < 4; i++)
+            worstError = std::fmax(worstError, std::fabs(stepped[i] - evaluated[i]));
+    }
+
+    bool passed = worstError <= FORWARD_DIFFERENCE_TOLERANCE;
+    std::cout << (passed ? "PASS" : "FAIL") << " forward differences, " << nSteps << " steps: worst error " << worstError << std::endl;
+    return passed;
+}
+
+// checks that the rows the renderer steps along with forward differences
+// match the patch evaluated the original way, along t then along s
+bool testPatchRows(const Homogeneous4 net[16], int nSteps) {
+    float worstError = 0.0f;
+    for (int sStep = 0; sStep <= nSteps; sStep++) {
+        float s = (float)sStep / nSteps;
+        BezierForwardDifferencer rowCurve(
+            bezierPoint(s, net[0], net[4], net[8], net[12]),
+            bezierPoint(s, net[1], net[5], net[9], net[13]),
+            bezierPoint(s, net[2], net[6], net[10], net[14]),
+            bezierPoint(s, net[3], net[7], net[11], net[15]),
+            nSteps);
+
+        for (int tStep = 0; tStep <= nSteps; tStep++) {
+            float t = (float)tStep / nSteps;
+            Homogeneous4 stepped = rowCurve.next();
+            Homogeneous4 evaluated = bezierPoint(s,
+                bezierPoint(t, net[0], net[1], net[2], net[3]),
+                bezierPoint(t, net[4], net[5], net[6], net[7]),
+                bezierPoint(t, net[8], net[9], net[10], net[11]),
+                bezierPoint(t, net[12], net[13], net[14], net[15]));
+            for (int i = 0; i < 4; i++)
+                worstError = std::fmax(worstError, std::fabs(stepped[i] - evaluated[i]));
+        }
+    }
+
+    bool passed = worstError <= FORWARD_DIFFERENCE_TOLERANCE;
+    std::cout << (passed ? "PASS" : "FAIL") << " patch rows, " << nSteps << " x " << nSteps << " samples: worst error " << worstError << std::endl;
+    return passed;
+}
+
+// checks that contracting the net with the basis tables gives the same
+// patch as evaluating it with the Bernstein polynomials
+bool testBasisTable(const Homogeneous4 net[16], int nSteps) {
+    BernsteinTable table;
+    table.Resize(nSteps);
+
+    float worstError = 0.0f;
+    for (int sStep = 0; sStep <= nSteps; sStep++) {
+        float s = (float)sStep / nSteps;
+        Homogeneous4 row[4];
+        for (int j = 0; j < 4; j++)
+            row[j] = bezierCombine(table[sStep], net[j], net[4 + j], net[8 + j], net[12 + j]);
+
+        for (int tStep = 0; tStep <= nSteps; tStep++) {
+            float t = (float)tStep / nSteps;
+            Homogeneous4 combined = bezierCombine(table[tStep], row[0], row[1], row[2], row[3]);
+            Homogeneous4 evaluated = bezierPoint(s,
+                bezierPoint(t, net[0], net[1], net[2], net[3]),
+                bezierPoint(t, net[4], net[5], net[6], net[7]),
+                bezierPoint(t, net[8], net[9], net[10], net[11]),
+                bezierPoint(t, net[12], net[13], net[14], net[15]));
+            for (int i = 0; i < 4; i++)
+                worstError = std::fmax(worstError, std::fabs(combined[i] - evaluated[i]));
+        }
+    }
+
+    // the table is only rebuilt when the resolution changes
+    const float *before = table[0];
+    table.Resize(nSteps);
+    bool kept = table[0] == before;
+
+    bool passed = worstError <= FORWARD_DIFFERENCE_TOLERANCE && kept;
+    std::cout << (passed ? "PASS" : "FAIL") << " basis table, " << nSteps << " x " << nSteps << " samples: worst error " << worstError << std::endl;
+    return passed;
+}
+
+// checks that every SIMD kernel level this CPU supports clips and projects
+// a row exactly as the scalar code does
+bool testPatchKernel(const Homogeneous4 rowControlPoints[4], int nSteps) {
+    BernsteinTable table;
+    table.Resize(nSteps);
+    float width = 1600.0f, height = 720.0f;
+
+    bool passed = true;
+    for (int level = KERNEL_SCALAR; level <= DetectKernelLevel(); level++) {
+        std::vector<float> x(nSteps + 1), y(nSteps + 1), z(nSteps + 1);
+        evaluatePatchRow(KernelLevel(level), rowControlPoints, table, width, height, x.data(), y.data(), z.data());
+
+        float worstError = 0.0f;
+        int clipMismatches = 0, nClipped = 0;
+        for (int step = 0; step <= nSteps; step++) {
+            Point3 expected = clipToViewport(bezierCombine(table[step], rowControlPoints[0], rowControlPoints[1], rowControlPoints[2], rowControlPoints[3]), width, height);
+            bool expectedClipped = expected.x == -1.0f && expected.y == -1.0f && expected.z == -1.0f;
+            bool clipped = x[step] == -1.0f && y[step] == -1.0f && z[step] == -1.0f;
+            nClipped += expectedClipped;
+            clipMismatches += expectedClipped != clipped;
+            worstError = std::fmax(worstError, std::fabs(x[step] - expected.x));
+            worstError = std::fmax(worstError, std::fabs(y[step] - expected.y));
+            worstError = std::fmax(worstError, std::fabs(z[step] - expected.z));
+        }
+
+        bool levelPassed = clipMismatches == 0 && worstError <= 1e-3f;
+        std::cout << (levelPassed ? "PASS" : "FAIL") << " " << KernelLevelName(KernelLevel(level)) << " kernel, " << nSteps + 1 << " samples ("
+                  << nClipped << " clipped): worst error " << worstError << " pixels, " << clipMismatches << " clip mismatches" << std::endl;
+        passed &= levelPassed;
+    }
+    return passed;
+}
+
+// checks that transforming the cached world space samples puts them where
+// evaluating the transformed net does, at every kernel level, and that the
+// cache is only reused for the same control points at a similar resolution
+bool testSurfaceCache(const Homogeneous4 net[16], const Matrix4 &mvp, int nSteps) {
+    float width = 1600.0f, height = 720.0f;
+    std::vector<Point3> worldNet;
+    Homogeneous4 clipNet[16];
+    for (int i = 0; i < 16; i++) {
+        worldNet.push_back(net[i].Point());
+        clipNet[i] = mvp * net[i];
+    }
+
+    SurfaceCache cache;
+    bool fitsBeforeBuild = cache.Fits(7, nSteps, nSteps);
+    cache.Build(worldNet, 7, nSteps, nSteps);
+    bool reuse = !fitsBeforeBuild && cache.Fits(7, nSteps, nSteps) && cache.Fits(7, (nSteps + 1) / 2, nSteps)
+              && !cache.Fits(8, nSteps, nSteps) && !cache.Fits(7, nSteps + 1, nSteps) && !cache.Fits(7, nSteps, nSteps / 3);
+
+    BernsteinTable table;
+    table.Resize(nSteps);
+    int nSamples = cache.rowLength();
+
+    bool passed = reuse;
+    for (int level = KERNEL_SCALAR; level <= DetectKernelLevel(); level++) {
+        std::vector<float> x(nSamples), y(nSamples), z(nSamples);
+        float worstError = 0.0f;
+        int clipMismatches = 0;
+        for (int s = 0; s <= nSteps; s++) {
+            int rowStart = s * nSamples;
+            transformSamples(KernelLevel(level), mvp, &cache.x[rowStart], &cache.y[rowStart], &cache.z[rowStart], nSamples, width, height, x.data(), y.data(), z.data());
+
+            Homogeneous4 rowControlPoints[4];
+            for (int j = 0; j < 4; j++)
+                rowControlPoints[j] = bezierCombine(table[s], clipNet[j], clipNet[4 + j], clipNet[8 + j], clipNet[12 + j]);
+            for (int t = 0; t <= nSteps; t++) {
+                Point3 expected = clipToViewport(bezierCombine(table[t], rowControlPoints[0], rowControlPoints[1], rowControlPoints[2], rowControlPoints[3]), width, height);
+                bool expectedClipped = expected.x == -1.0f && expected.y == -1.0f && expected.z == -1.0f;
+                bool clipped = x[t] == -1.0f && y[t] == -1.0f && z[t] == -1.0f;
+                clipMismatches += expectedClipped != clipped;
+                if (expectedClipped || clipped)
+                    continue;
+                worstError = std::fmax(worstError, std::fabs(x[t] - expected.x));
+                worstError = std::fmax(worstError, std::fabs(y[t] - expected.y));
+                worstError = std::fmax(worstError, std::fabs(z[t] - expected.z));
+            }
+        }
+
+        bool levelPassed = reuse && clipMismatches == 0 && worstError <= 1e-2f;
+        std::cout << (levelPassed ? "PASS" : "FAIL") << " " << KernelLevelName(KernelLevel(level)) << " transform of cached samples, " << nSteps << " steps: worst error "
+                  << worstError << " pixels, " << clipMismatches << " clip mismatches, " << (reuse ? "reused as expected" : "wrong reuse") << std::endl;
+        passed &= levelPassed;
+    }
+    return passed;
+}
+
+// checks that moving the cached samples to follow nudged control points
+// gives the same samples as evaluating the nudged net afresh
+bool testSurfaceCacheUpdate(const Homogeneous4 net[16], int nSteps) {
+    std::vector<Point3> worldNet;
+    for (int i = 0; i < 16; i++)
+        worldNet.push_back(net[i].Point());
+
+    // two vertices in one column of the net and one in another, as a run of key presses
+    Vector3 deltas[16];
+    deltas[5] = Vector3(0.1f, 0.0f, -0.3f);
+    deltas[9] = Vector3(0.0f, -0.2f, 0.0f);
+    deltas[14] = Vector3(0.0f, 0.0f, 0.1f);
+
+    SurfaceCache updated, rebuilt;
+    updated.Build(worldNet, 1, nSteps, nSteps);
+    updated.ApplyChanges(deltas, 2);
+    for (int i = 0; i < 16; i++)
+        worldNet[i] = worldNet[i] + deltas[i];
+    rebuilt.Build(worldNet, 2, nSteps, nSteps);
+
+    float worstError = 0.0f;
+    for (size_t i = 0; i < rebuilt.x.size(); i++) {
+        worstError = std::fmax(worstError, std::fabs(updated.x[i] - rebuilt.x[i]));
+        worstError = std::fmax(worstError, std::fabs(updated.y[i] - rebuilt.y[i]));
+        worstError = std::fmax(worstError, std::fabs(updated.z[i] - rebuilt.z[i]));
+    }
+
+    bool passed = updated.version == 2 && worstError <= 1e-5f;
+    std::cout << (passed ? "PASS" : "FAIL") << " cached samples updated for 3 moved vertices, " << nSteps << " steps: worst error " << worstError << std::endl;
+    return passed;
+}
+
+// checks that leaving out the clip tests for a row known to be inside the view
+// volume gives exactly the same samples as testing them, at every kernel level
+bool testUnclippedRow(const Homogeneous4 rowControlPoints[4], int nSteps) {
+    BernsteinTable table;
+    table.Resize(nSteps);
+    float width = 640.0f, height = 480.0f;
+
+    bool passed = true;
+    for (int level = KERNEL_SCALAR; level <= DetectKernelLevel(); level++) {
+        std::vector<float> x(nSteps + 1), y(nSteps + 1), z(nSteps + 1), unclippedX(nSteps + 1), unclippedY(nSteps + 1), unclippedZ(nSteps + 1);
+        evaluatePatchRow(KernelLevel(level), rowControlPoints, table, width, height, x.data(), y.data(), z.data(), true);
+        evaluatePatchRow(KernelLevel(level), rowControlPoints, table, width, height, unclippedX.data(), unclippedY.data(), unclippedZ.data(), false);
+
+        int differences = 0;
+        for (int step = 0; step <= nSteps; step++)
+            differences += x[step] != unclippedX[step] || y[step] != unclippedY[step] || z[step] != unclippedZ[step] || x[step] == -1.0f;
+
+        bool levelPassed = differences == 0;
+        std::cout << (levelPassed ? "PASS" : "FAIL") << " " << KernelLevelName(KernelLevel(level)) << " kernel without clip tests, "
+                  << nSteps + 1 << " samples: " << differences << " differences" << std::endl;
+        passed &= levelPassed;
+    }
+    return passed;
+}
+
+// checks that the adaptive sample counts leave neighbouring samples no further apart on
+// screen than the target density allows, unless allowCapped and the patch is too big on
+// screen for MAX_SAMPLE_STEPS to reach across it, and never further apart than the speeds allow
+bool testAdaptiveSampling(const Homogeneous4 clipNet[16], float width, float height, float samplesPerPixel, bool allowCapped = false) {
+    float speedS, speedT;
+    if (!projectedNetSpeeds(clipNet, width, height, speedS, speedT)) {
+        std::cout << "FAIL adaptive sampling: net should be in front of the camera" << std::endl;
+        return false;
+    }
+    int nStepsS = samplingSteps(speedS, samplesPerPixel);
+    int nStepsT = samplingSteps(speedT, samplesPerPixel);
+
+    BernsteinTable sTable, tTable;
+    sTable.Resize(nStepsS);
+    tTable.Resize(nStepsT);
+
+    // evaluate the grid, projecting each sample to the screen
+    std::vector<float> screenX((nStepsS + 1) * (nStepsT + 1)), screenY(screenX.size());
+    for (int s = 0; s <= nStepsS; s++) {
+        Homogeneous4 row[4];
+        for (int j = 0; j < 4; j++)
+            row[j] = bezierCombine(sTable[s], clipNet[j], clipNet[4 + j], clipNet[8 + j], clipNet[12 + j]);
+        for (int t = 0; t <= nStepsT; t++) {
+            Homogeneous4 clipPoint = bezierCombine(tTable[t], row[0], row[1], row[2], row[3]);
+            screenX[s * (nStepsT + 1) + t] = (clipPoint.x / clipPoint.w + 1) / 2 * width;
+            screenY[s * (nStepsT + 1) + t] = (clipPoint.y / clipPoint.w + 1) / 2 * height;
+        }
+    }
+
+    // the largest gap between neighbours in each direction
+    float widestGapS = 0.0f, widestGapT = 0.0f;
+    for (int s = 0; s <= nStepsS; s++)
+        for (int t = 0; t <= nStepsT; t++) {
+            int here = s * (nStepsT + 1) + t;
+            if (t < nStepsT)
+                widestGapT = std::fmax(widestGapT, std::hypot(screenX[here + 1] - screenX[here], screenY[here + 1] - screenY[here]));
+            if (s < nStepsS)
+                widestGapS = std::fmax(widestGapS, std::hypot(screenX[here + nStepsT + 1] - screenX[here], screenY[here + nStepsT + 1] - screenY[here]));
+        }
+    float widestGap = std::fmax(widestGapS, widestGapT);
+
+    // the speeds have to be real bounds, so no gap is wider than a step at them
+    // (with a little slack for rounding in float)
+    bool withinSpeeds = widestGapS <= speedS / nStepsS * 1.001f && widestGapT <= speedT / nStepsT * 1.001f;
+    bool capped = nStepsS == MAX_SAMPLE_STEPS || nStepsT == MAX_SAMPLE_STEPS;
+    bool noHoles = widestGap <= 1.001f / samplesPerPixel;
+    bool passed = withinSpeeds && (noHoles || (capped && allowCapped));
+    std::cout << (passed ? "PASS" : "FAIL") << " adaptive sampling, " << nStepsS + 1 << " x " << nStepsT + 1 << " samples at "
+              << width << " x " << height << (capped ? " (capped)" : "") << ": widest gap " << widestGap << " pixels, at most "
+              << 1.0f / samplesPerPixel << std::endl;
+    return passed;
+}
+
+// counts how many times each pixel is written by the rasterizer
+struct CoverageCounter {
+    long width;
+    std::vector<int> counts;
+    void operator()(float x, float y, float, float, float) { counts[(long)y * width + (long)x]++; }
+};
+
+// checks that two triangles sharing an edge cover every pixel centre of
+// their quad exactly once, with no gaps or double writes along the diagonal
+bool testWatertightTriangles(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3) {
+    long width = 64, height = 64;
+    CoverageCounter coverage{ width, std::vector<int>(width * height, 0) };
+
+    RasterVertex quad[4] = {
+        RasterVertex{ x0, y0, 0.0f, 1.0f, 0.0f, 0.0f }, RasterVertex{ x1, y1, 0.0f, 1.0f, 0.0f, 1.0f },
+        RasterVertex{ x2, y2, 0.0f, 1.0f, 1.0f, 1.0f }, RasterVertex{ x3, y3, 0.0f, 1.0f, 1.0f, 0.0f } };
+    rasterizeTriangle(quad[0], quad[1], quad[2], width, height, coverage);
+    rasterizeTriangle(quad[0], quad[2], quad[3], width, height, coverage);
+
+    int doubles = 0, covered = 0;
+    for (int count : coverage.counts) {
+        covered += count > 0;
+        doubles += count > 1;
+    }
+
+    bool passed = doubles == 0 && covered > 0;
+    std::cout << (passed ? "PASS" : "FAIL") << " watertight triangles: " << covered << " pixels covered, " << doubles << " written twice" << std::endl;
+    return passed;
+}
+
+// checks that a grid of samples of the patch, filled as quads, leaves no cracks
+// between them: no pixel is written twice, and none is missed whose neighbours all are
+bool testMeshCoverage(const Homogeneous4 clipControlPoints[16], long width, long height, int nSteps) {
+    BernsteinTable table;
+    table.Resize(nSteps);
+    std::vector<Homogeneous4> grid;
+    evaluatePatchGrid(clipControlPoints, table, table, grid);
+
+    CoverageCounter coverage{ width, std::vector<int>(width * height, 0) };
+    for (int s = 0; s < nSteps; s++)
+        for (int t = 0; t < nSteps; t++) {
+            const Homogeneous4 *cell = &grid[s * (nSteps + 1) + t];
+            Homogeneous4 corners[4] = { cell[0], cell[1], cell[nSteps + 1], cell[nSteps + 2] };
+            rasterizeQuad(DetectKernelLevel(), corners, (float)s / nSteps, (float)(s + 1) / nSteps, (float)t / nSteps, (float)(t + 1) / nSteps, width, height, coverage);
+        }
+
+    int doubles = 0, covered = 0, holes = 0;
+    for (long y = 0; y < height; y++)
+        for (long x = 0; x < width; x++) {
+            long pixel = y * width + x;
+            covered += coverage.counts[pixel] > 0;
+            doubles += coverage.counts[pixel] > 1;
+            if (x > 0 && y > 0 && x + 1 < width && y + 1 < height && coverage.counts[pixel] == 0
+                && coverage.counts[pixel - 1] && coverage.counts[pixel + 1] && coverage.counts[pixel - width] && coverage.counts[pixel + width])
+                holes++;
+        }
+
+    bool passed = doubles == 0 && holes == 0 && covered > 0;
+    std::cout << (passed ? "PASS" : "FAIL") << " mesh coverage, " << nSteps << " x " << nSteps << " quads at " << width << " x " << height
+              << ": " << covered << " pixels covered, " << doubles << " written twice, " << holes << " holes" << std::endl;
+    return passed;
+}
+
+// draws lines, markers, a mesh of the patch and loose fragments straight into a depth buffer,
+// and again through the tile bins, and checks the two images come out identical
+// the screen is not a whole number of tiles, and some of everything straddles the tile edges
+bool testTileBinner(const Homogeneous4 clipControlPoints[16], long width, long height, int nSteps) {
+    RGBAValue clearColour(204.0f, 204.0f, 153.0f, 255.0f);
+    auto shade = [](FragmentShade fragmentShade) {
+        return fragmentShade.IsSurface() ? RGBAValue(255.0f * fragmentShade.S(), 255.0f / 2, 255.0f * fragmentShade.T(), 255.0f) : fragmentShade.Colour();
+    };
+
+    Point3 lines[5][2] = {
+        { Point3(3.5f, 7.25f, 0.5f), Point3(float(width) - 2.0f, float(height) - 5.5f, -0.5f) },
+        { Point3(100.2f, -40.0f, 0.1f), Point3(110.7f, float(height) + 40.0f, 0.1f) },
+        { Point3(-500.0f, 60.3f, -0.2f), Point3(float(width) + 500.0f, 70.9f, 0.3f) },
+        { Point3(64.0f, 64.0f, 0.0f), Point3(128.0f, 0.0f, 0.0f) },
+        { Point3(20.0f, 20.0f, 0.0f), Point3(20.0f, 20.0f, 0.0f) } };
+    Point3 markers[3] = { Point3(63.7f, 64.2f, -0.9f), Point3(2.0f, 3.0f, 0.2f), Point3(float(width) - 1.5f, 100.0f, 0.4f) };
+    std::vector<Point3> fragments;
+    for (int i = 0; i < 500; i++)
+        fragments.push_back(Point3(std::fmod(i * 37.3f, (float)width), std::fmod(i * 17.9f, (float)height), std::fmod(i * 0.013f, 2.0f) - 1.0f));
+
+    BernsteinTable table;
+    table.Resize(nSteps);
+    std::vector<Homogeneous4> grid;
+    evaluatePatchGrid(clipControlPoints, table, table, grid);
+
+    // draws every quad of the mesh, handing its triangles to emitTriangle
+    auto drawMesh = [&](auto &emitTriangle) {
+        for (int s = 0; s < nSteps; s++)
+            for (int t = 0; t < nSteps; t++) {
+                const Homogeneous4 *cell = &grid[s * (nSteps + 1) + t];
+                Homogeneous4 corners[4] = { cell[0], cell[1], cell[nSteps + 1], cell[nSteps + 2] };
+                triangulateQuad(corners, (float)s / nSteps, (float)(s + 1) / nSteps, (float)t / nSteps, (float)(t + 1) / nSteps, width, height, emitTriangle);
+            }
+    };
+
+    // straight into the whole screen, in the order a tile resolves them
+    RGBAImage direct;
+    DepthBuffer directDepth;
+    direct.Resize(width, height);
+    directDepth.Resize(width, height);
+    direct.clear(clearColour);
+    directDepth.clear(std::numeric_limits<float>::max());
+    RGBAValue colour;
+    auto write = [&](float x, float y, float z) {
+        if (directDepth.depthTest(Point3(x, y, z)))
+            direct.setPixel(Point3(x, y, z), colour);
+    };
+    auto writeSurface = [&](float x, float y, float z, float s, float t) {
+        colour = shade(FragmentShade::Surface(s, t));
+        write(x, y, z);
+    };
+    for (auto &line : lines) {
+        colour = RGBAValue(255.0f, 0.0f, 0.0f, 255.0f);
+        rasterizeLine(line[0], line[1], width, height, write);
+    }
+    MarkerStamp stamp;
+    stamp.Build(5);
+    for (Point3 &marker : markers) {
+        colour = RGBAValue(0.0f, 255.0f, 0.0f, 255.0f);
+        rasterizeMarker(marker, stamp, PixelRect{ 0, 0, width, height }, write);
+    }
+    auto fillTriangle = [&](const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2) {
+        rasterizeTriangle(v0, v1, v2, width, height, writeSurface);
+    };
+    drawMesh(fillTriangle);
+    for (Point3 &fragment : fragments) {
+        colour = RGBAValue(0.0f, 0.0f, 255.0f, 255.0f);
+        write(fragment.x, fragment.y, fragment.z);
+    }
+
+    // and through the bins
+    TileBinner binner;
+    binner.Resize(width, height);
+    for (auto &line : lines)
+        binner.AddLine(line[0], line[1], FragmentShade::Flat(RGBAValue(255.0f, 0.0f, 0.0f, 255.0f)));
+    for (Point3 &marker : markers)
+        binner.AddMarker(marker, stamp, FragmentShade::Flat(RGBAValue(0.0f, 255.0f, 0.0f, 255.0f)));
+    auto binTriangle = [&](const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2) {
+        binner.AddTriangle(v0, v1, v2);
+    };
+    drawMesh(binTriangle);
+    for (Point3 &fragment : fragments)
+        binner.AddFragment(fragment, FragmentShade::Flat(RGBAValue(0.0f, 0.0f, 255.0f, 255.0f)));
+
+    RGBAImage tiled;
+    DepthBuffer tiledDepth;
+    tiled.Resize(width, height);
+    tiledDepth.Resize(width, height);
+    // the tiles are filled with the SIMD triangle kernel, so this checks it against the scalar code too
+    binner.Resolve(DetectKernelLevel(), tiled, tiledDepth, FragmentShade::Flat(clearColour), shade);
+
+    long differences = 0, drawn = 0;
+    for (long y = 0; y < height; y++)
+        for (long x = 0; x < width; x++) {
+            const RGBAValue &a = direct[y][x], &b = tiled[y][x];
+            differences += a.red != b.red || a.green != b.green || a.blue != b.blue || a.alpha != b.alpha || directDepth[y][x] != tiledDepth[y][x];
+            drawn += directDepth[y][x] != std::numeric_limits<float>::max();
+        }
+
+    bool passed = differences == 0 && drawn > 0;
+    std::cout << (passed ? "PASS" : "FAIL") << " tile binner at " << width << " x " << height << ": " << binner.tilesX << " x " << binner.tilesY << " tiles, "
+              << drawn << " pixels drawn, " << differences << " differ from drawing directly" << std::endl;
+    return passed;
+}
+
+// one fragment written by the triangle rasterizer
+struct TriangleFragment {
+    float x, y, z, s, t;
+    bool operator==(const TriangleFragment &other) const {
+        return x == other.x && y == other.y && z == other.z && s == other.s && t == other.t;
+    }
+};
+
+// fills a batch of pseudo-random triangles up to the given size, some of them straddling the
+// edges of the rectangle they are drawn into, with every triangle kernel level this CPU supports
+// and checks each level writes exactly the fragments the scalar code does, and that the
+// interpolated depth and parameters agree with the barycentric weights of the pixel centres
+bool testTriangleKernel(float size) {
+    PixelRect bounds{ 64, 64, 192, 160 };
+    std::vector<RasterVertex> vertices;
+    unsigned int seed = 12345;
+    auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+    for (int triangle = 0; triangle < 200; triangle++) {
+        float centreX = 40.0f + 176.0f * random(), centreY = 40.0f + 144.0f * random();
+        for (int corner = 0; corner < 3; corner++) {
+            float w = 1.0f + 3.0f * random();
+            vertices.push_back(RasterVertex{ centreX + size * (random() - 0.5f), centreY + size * (random() - 0.5f), 2.0f * random() - 1.0f, 1.0f / w, random(), random() });
+        }
+    }
+
+    std::vector<TriangleFragment> expected;
+    bool passed = true;
+    for (int level = KERNEL_SCALAR; level <= DetectKernelLevel(); level++) {
+        std::vector<TriangleFragment> fragments;
+        auto collect = [&fragments](float x, float y, float z, float s, float t) { fragments.push_back(TriangleFragment{ x, y, z, s, t }); };
+        for (size_t v = 0; v < vertices.size(); v += 3)
+            rasterizeTriangle(KernelLevel(level), vertices[v], vertices[v + 1], vertices[v + 2], bounds, collect);
+
+        float worstError = 0.0f;
+        if (level == KERNEL_SCALAR) {
+            expected = fragments;
+            // compare with the barycentric weights, which are exact for the snapped vertices,
+            // working triangle by triangle from a fresh fill of each
+            for (size_t v = 0; v < vertices.size(); v += 3) {
+                RasterVertex corner[3];
+                for (int i = 0; i < 3; i++) {
+                    corner[i] = vertices[v + i];
+                    corner[i].x = snapToSubpixel(corner[i].x) / (float)RASTER_SUBPIXEL_ONE;
+                    corner[i].y = snapToSubpixel(corner[i].y) / (float)RASTER_SUBPIXEL_ONE;
+                }
+                double area = (double)(corner[1].x - corner[0].x) * (corner[2].y - corner[0].y) - (double)(corner[1].y - corner[0].y) * (corner[2].x - corner[0].x);
+                auto check = [&](float x, float y, float z, float s, float t) {
+                    double weight[3];
+                    for (int i = 0; i < 3; i++) {
+                        const RasterVertex &from = corner[(i + 1) % 3], &to = corner[(i + 2) % 3];
+                        weight[i] = ((double)(from.y - to.y) * (x - from.x) + (double)(to.x - from.x) * (y - from.y)) / area;
+                    }
+                    double invW = 0.0, sOverW = 0.0, tOverW = 0.0, depth = 0.0;
+                    for (int i = 0; i < 3; i++) {
+                        depth += weight[i] * corner[i].z;
+                        invW += weight[i] * corner[i].invW;
+                        sOverW += weight[i] * corner[i].s * corner[i].invW;
+                        tOverW += weight[i] * corner[i].t * corner[i].invW;
+                    }
+                    worstError = std::fmax(worstError, (float)std::fabs(z - depth));
+                    worstError = std::fmax(worstError, (float)std::fabs(s - sOverW / invW));
+                    worstError = std::fmax(worstError, (float)std::fabs(t - tOverW / invW));
+                };
+                rasterizeTriangle(KERNEL_SCALAR, vertices[v], vertices[v + 1], vertices[v + 2], bounds, check);
+            }
+        }
+
+        bool levelPassed = fragments == expected && !fragments.empty() && worstError <= 1e-4f;
+        std::cout << (levelPassed ? "PASS" : "FAIL") << " " << KernelLevelName(KernelLevel(level)) << " triangle kernel, triangles up to " << size << " pixels: "
+                  << fragments.size() << " fragments (" << expected.size() << " expected), worst error " << worstError << std::endl;
+        passed &= levelPassed;
+    }
+    return passed;
+}
+
+// checks that a fragment's shade gives back its flat colour exactly, and its (s, t) closely
+// enough that the surface colour made from them is never more than one step out
+bool testFragmentShade(int nSteps) {
+    float worstError = 0.0f;
+    int worstColourError = 0;
+    bool flatExact = true, tagsRight = true, coverageRight = true;
+    for (int i = 0; i <= nSteps; i++)
+        for (int j = 0; j <= nSteps; j++) {
+            float s = (float)i / nSteps, t = (float)j / nSteps;
+            FragmentShade shade = FragmentShade::Surface(s, t);
+            tagsRight &= shade.IsSurface();
+            worstError = std::fmax(worstError, std::fmax(std::fabs(shade.S() - s), std::fabs(shade.T() - t)));
+            RGBAValue exact(255.0f * s, 255.0f / 2, 255.0f * t, 255.0f), shaded(255.0f * shade.S(), 255.0f / 2, 255.0f * shade.T(), 255.0f);
+            worstColourError = std::max(worstColourError, std::max(std::abs(exact.red - shaded.red), std::abs(exact.blue - shaded.blue)));
+
+            RGBAValue colour((unsigned char)(i * 7), (unsigned char)(j * 13), (unsigned char)(i + j));
+            FragmentShade flat = FragmentShade::Flat(colour);
+            RGBAValue back = flat.Colour();
+            tagsRight &= !flat.IsSurface();
+            flatExact &= back.red == colour.red && back.green == colour.green && back.blue == colour.blue && back.alpha == 255;
+
+            // a marker edge keeps its colour exactly and its coverage to within a quantization step
+            int coverage = (i * 37 + j) % 256;
+            FragmentShade edge = FragmentShade::Flat(colour, (uint8_t)coverage);
+            back = edge.Colour();
+            tagsRight &= !edge.IsSurface();
+            flatExact &= back.red == colour.red && back.green == colour.green && back.blue == colour.blue;
+            coverageRight &= std::abs(edge.Coverage() - coverage) <= 255 / SHADE_COVERAGE_MAX / 2 + 1;
+        }
+    coverageRight &= FragmentShade::Flat(RGBAValue()).Coverage() == 255 && FragmentShade::Flat(RGBAValue(), 255).Coverage() == 255
+                  && FragmentShade::Flat(RGBAValue(), 0).Coverage() == 0 && FragmentShade::Surface(0.5f, 0.5f).Coverage() == 255;
+
+    // the ends of the parameter range come back exactly
+    FragmentShade corner = FragmentShade::Surface(1.0f, 0.0f);
+    bool endsExact = corner.S() == 1.0f && corner.T() == 0.0f;
+
+    bool passed = tagsRight && flatExact && coverageRight && endsExact && worstError <= 0.5f / SHADE_PARAMETER_MAX && worstColourError <= 1;
+    std::cout << (passed ? "PASS" : "FAIL") << " fragment shade, " << (nSteps + 1) * (nSteps + 1) << " parameters: worst error " << worstError
+              << ", worst colour error " << worstColourError << (flatExact ? ", flat colours exact" : ", flat colours differ")
+              << (coverageRight ? ", coverage kept" : ", coverage lost") << std::endl;
+    return passed;
+}
+
+// radix sorts a batch of pseudo-random fragments, several to a pixel and some just off the
+// edges of the screen, and checks the nearest fragment it leaves last at each pixel is the one
+// comparing the fragments themselves and sorting them with std::sort finds
+bool testFragmentSorter(long width, long height, long nFragments) {
+    std::vector<Point3> points;
+    unsigned int seed = 4321;
+    auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+    for (long i = 0; i < nFragments; i++)
+        points.push_back(Point3((width + 1.0f) * random() - 0.5f, (height + 1.0f) * random() - 0.5f, 2.0f * random() - 1.0f));
+
+    // the comparison the Painter's algorithm used to sort with
+    std::vector<uint32_t> expected(nFragments);
+    for (long i = 0; i < nFragments; i++)
+        expected[i] = (uint32_t)i;
+    std::sort(expected.begin(), expected.end(), [&points](uint32_t left, uint32_t right) {
+        const Point3 &l = points[left], &r = points[right];
+        if ((int)l.y != (int)r.y) return (int)l.y > (int)r.y;
+        if ((int)l.x != (int)r.x) return (int)l.x < (int)r.x;
+        return l.z > r.z;
+    });
+
+    FragmentSorter sorter;
+    sorter.Resize(width, height);
+    sorter.Reserve(nFragments);
+    for (long i = 0; i < nFragments; i++) {
+        sorter.keys[i] = sorter.Key(points[i]);
+        sorter.payloads[i] = (uint32_t)i;
+    }
+    sorter.Sort();
+
+    // the fragment left last at each pixel on screen by each order
+    auto nearest = [&](const std::vector<uint32_t> &order) {
+        std::vector<long> front(width * height, -1);
+        for (long i = 0; i < nFragments; i++) {
+            const Point3 &point = points[order[i]];
+            bool lastAtPixel = i == nFragments - 1 || (int)points[order[i + 1]].x != (int)point.x || (int)points[order[i + 1]].y != (int)point.y;
+            if (lastAtPixel && point.x >= 0 && point.x < width && point.y >= 0 && point.y < height)
+                front[(int)point.y * width + (int)point.x] = order[i];
+        }
+        return front;
+    };
+    std::vector<long> expectedFront = nearest(expected), front = nearest(sorter.payloads);
+
+    long nUnsorted = 0, nDiffering = 0;
+    for (long i = 1; i < nFragments; i++)
+        nUnsorted += sorter.keys[i] < sorter.keys[i - 1];
+    for (long pixel = 0; pixel < width * height; pixel++)
+        nDiffering += front[pixel] != expectedFront[pixel];
+
+    // splitting the sorted keys into chunks where rows begin, as the resolve does between threads,
+    // must cover every key once and never leave a row in two chunks
+    long nBadSplits = 0;
+    for (long nChunks = 1; nChunks <= 7; nChunks++) {
+        size_t previous = sorter.RowStart(0);
+        nBadSplits += previous != 0;
+        for (long chunk = 1; chunk <= nChunks; chunk++) {
+            size_t start = sorter.RowStart(nFragments * chunk / nChunks);
+            bool sharesRow = start > 0 && start < (size_t)nFragments && sorter.Row(sorter.keys[start]) == sorter.Row(sorter.keys[start - 1]);
+            nBadSplits += start < previous || sharesRow;
+            previous = start;
+        }
+        nBadSplits += previous != (size_t)nFragments;
+    }
+
+    bool passed = nUnsorted == 0 && nDiffering == 0 && nBadSplits == 0;
+    std::cout << (passed ? "PASS" : "FAIL") << " fragment sorter, " << nFragments << " fragments at " << width << " x " << height << " with "
+              << sorter.keyBits << " bit keys: " << nUnsorted << " out of order, " << nDiffering << " pixels differ from std::sort, "
+              << nBadSplits << " bad row splits" << std::endl;
+    return passed;
+}
+
+// checks that the fragments of a frame come back from the arena's blocks, counted as one list,
+// exactly once each, including across empty blocks, and that the high-water marks keep the largest frame
+bool testFragmentArena(long nFragments) {
+    FragmentArena arena;
+    long nWrong = 0;
+    for (long nInFrame : { nFragments, nFragments / 3 }) {
+        // as if four threads had each added a share, one of them nothing
+        arena.Clear();
+        arena.threadFragments.resize(4);
+        for (long i = 0; i < nInFrame; i++) {
+            int thread = i % 3 == 0 ? 0 : (i % 3 == 1 ? 2 : 3);
+            arena.threadFragments[thread].push_back(Fragment{ Point3((float)i, 0.0f, 0.0f), FragmentShade{ (uint32_t)i } });
+        }
+
+        size_t total = arena.Gather();
+        std::vector<int> seen(nInFrame, 0);
+        for (size_t i = 0; i < total; i++)
+            seen[arena[i].shade.value]++;
+        nWrong += (long)total != nInFrame;
+        for (int count : seen)
+            nWrong += count != 1;
+    }
+
+    // one more frame added through Add(), as the renderer does
+    arena.Clear();
+    for (long i = 0; i < 10; i++) {
+        arena.Reserve(1);
+        arena.Add(Fragment{ Point3((float)i, 0.0f, 0.0f), FragmentShade{ (uint32_t)i } });
+    }
+    nWrong += arena.Gather() != 10;
+
+    bool marksKept = arena.highWaterMark == (size_t)nFragments && arena.threadHighWaterMark == (size_t)(nFragments + 2) / 3;
+    bool passed = nWrong == 0 && marksKept;
+    std::cout << (passed ? "PASS" : "FAIL") << " fragment arena, " << nFragments << " fragments: " << nWrong << " missing or repeated, high-water mark "
+              << arena.highWaterMark << " (" << arena.threadHighWaterMark << " in one block)" << std::endl;
+    return passed;
+}
+
+// checks a marker stamp of the given radius: its runs are the pixels at least half covered, it is
+// symmetric, its coverage adds up to the area of its disc, and stamped partly off screen it writes
+// just the on screen pixels it would write whole
+bool testMarkerStamp(int radius) {
+    MarkerStamp stamp;
+    stamp.Build(radius);
+
+    long nWrong = 0, nCovered = 0;
+    double area = 0.0;
+    for (int dy = -radius; dy <= radius; dy++)
+        for (int dx = -radius; dx <= radius; dx++) {
+            int row = dy + radius;
+            bool inRun = dx >= stamp.spanStarts[row] && dx < stamp.spanEnds[row];
+            nWrong += inRun != (stamp.Coverage(dx, dy) >= 128);
+            nWrong += stamp.Coverage(dx, dy) != stamp.Coverage(-dx, dy) || stamp.Coverage(dx, dy) != stamp.Coverage(dy, dx);
+            nCovered += inRun;
+            area += stamp.Coverage(dx, dy) / 255.0;
+        }
+    float discRadius = radius + 0.5f;
+    bool areaMatches = fabs(area - M_PI * discRadius * discRadius) < 0.02 * M_PI * discRadius * discRadius + 0.5;
+
+    // stamped whole, then across a corner of the screen
+    long width = 40, height = 30;
+    std::vector<int> whole(width * height, 0), clipped(width * height, 0);
+    Point3 centre(2.7f, 28.2f, 0.25f);
+    long nWritten = 0;
+    auto writeWhole = [&](float x, float y, float z) {
+        nWritten++;
+        if (x >= 0 && x < width && y >= 0 && y < height && z == 0.25f)
+            whole[(long)y * width + (long)x]++;
+    };
+    rasterizeMarker(centre, stamp, PixelRect{ -100, -100, 100, 100 }, writeWhole);
+    auto writeClipped = [&](float x, float y, float) { clipped[(long)y * width + (long)x]++; };
+    rasterizeMarker(centre, stamp, PixelRect{ 0, 0, width, height }, writeClipped);
+    nWrong += nWritten != stamp.nPixels || nCovered != stamp.nPixels;
+    nWrong += whole != clipped;
+
+    bool passed = nWrong == 0 && areaMatches;
+    std::cout << (passed ? "PASS" : "FAIL") << " marker stamp, radius " << radius << ": " << stamp.nPixels << " pixels, coverage adds up to "
+              << area << " of " << M_PI * discRadius * discRadius << ", " << nWrong << " wrong" << std::endl;
+    return passed;
+}
+
+// publishes frames with known stage times, more than the ring buffer holds, and checks the
+// rolling percentiles against those worked out from every time directly
+bool testFrameTimer(int nFrames) {
+    FrameTimer timer;
+    std::vector<uint64_t> times;
+    long nWrong = timer.FrameCount() != 0 || timer.Statistics(STAGE_FRAME).p99 != 0.0f;
+    for (int frame = 0; frame < nFrames; frame++) {
+        timer.BeginFrame();
+        // a spread of times in whole microseconds, out of order, with the clear stage in two parts
+        uint64_t time = 1000 * (uint64_t)((frame * 7919) % 1000 + 1);
+        times.push_back(time);
+        timer.Record(STAGE_CLEAR, time / 4);
+        timer.Record(STAGE_CLEAR, time - time / 4);
+        timer.Record(STAGE_RESOLVE, 2 * time);
+        timer.EndFrame();
+    }
+
+    // the same percentiles of the frames the timer keeps
+    size_t nKept = std::min<size_t>(times.size(), FRAME_TIMER_HISTORY - 1);
+    std::vector<uint64_t> kept(times.end() - nKept, times.end());
+    std::sort(kept.begin(), kept.end());
+    auto percentile = [&](size_t percent) { return kept[std::max<size_t>((percent * nKept + 99) / 100, 1) - 1] / 1.0e6f; };
+    StageStatistics clear = timer.Statistics(STAGE_CLEAR), resolve = timer.Statistics(STAGE_RESOLVE), net = timer.Statistics(STAGE_NET);
+    nWrong += timer.FrameCount() != (uint64_t)nFrames;
+    nWrong += clear.last != times.back() / 1.0e6f;
+    nWrong += clear.p50 != percentile(50) || clear.p95 != percentile(95) || clear.p99 != percentile(99);
+    nWrong += resolve.p50 != 2.0f * percentile(50) || resolve.p99 != 2.0f * percentile(99);
+    nWrong += net.last != 0.0f || net.p99 != 0.0f;
+    nWrong += std::string(FrameTimer::StageName(STAGE_DRAW_PIXELS)) != "glDrawPixels";
+
+    bool passed = nWrong == 0;
+    std::cout << (passed ? "PASS" : "FAIL") << " frame timer over " << nFrames << " frames: p50 " << clear.p50 << " p95 " << clear.p95
+              << " p99 " << clear.p99 << " ms, " << nWrong << " wrong" << std::endl;
+    return passed;
+}
+
+// checks that nothing is recorded while tracing is off, that spans past a thread's room are
+// counted rather than kept, and that a traced frame's stages and thread spans are written out
+bool testFrameTracer(const std::vector<Point3> &net) {
+    FrameTracer tracer;
+    long nWrong = 0;
+    { TraceScope untraced(tracer, "untraced"); }
+    tracer.Add("untraced", 1, 2);
+
+    tracer.Start(4);
+    nWrong += !tracer.Enabled();
+    for (int i = 0; i < 6; i++)
+        tracer.Add("span", FrameTimer::Now(), FrameTimer::Now());
+    nWrong += tracer.Dropped() != 2;
+    std::ostringstream trace;
+    size_t nSpans = tracer.Stop(trace);
+    std::string json = trace.str();
+    auto count = [](const std::string &text, const std::string &pattern) {
+        long n = 0;
+        for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1))
+            n++;
+        return n;
+    };
+    nWrong += tracer.Enabled() || nSpans != 4 || count(json, "\"ph\":\"X\"") != 4 || count(json, "untraced") != 0;
+    nWrong += json.find("{\"traceEvents\":[") != 0 || json.find("\"droppedSpans\":2}") == std::string::npos;
+    nWrong += count(json, "{") != count(json, "}") || count(json, "[") != count(json, "]");
+
+    // a frame of the renderer, which traces its stages on the calling thread and its loops on every thread
+    ControlPoints patch;
+    patch.vertices = net;
+    RenderParameters parameters(&patch);
+    parameters.bezierEnabled = true;
+    parameters.fragmentResolveMode = PAINTERS_ALGORITHM;
+    PatchRenderer renderer(&patch, &parameters);
+    renderer.Resize(160, 120);
+    renderer.frameTracer.Start();
+    renderer.Render();
+    std::ostringstream frameTrace;
+    renderer.frameTracer.Stop(frameTrace);
+    json = frameTrace.str();
+    for (const char *name : { "\"clear\"", "\"bezier\"", "\"sort\"", "\"resolve\"", "\"bezier cached rows\"", "\"planes lines\"", "\"painter's resolve\"" })
+        nWrong += count(json, name) == 0;
+
+    bool passed = nWrong == 0;
+    std::cout << (passed ? "PASS" : "FAIL") << " frame tracer: " << nSpans << " spans kept, " << count(json, "\"ph\":\"X\"")
+              << " spans in a traced frame, " << nWrong << " wrong" << std::endl;
+    return passed;
+}
+
+// renders a patch with the Qt-free renderer, as the window and the offline renderer do, with each
+// surface renderer and resolve mode, and checks that a frame is repeatable, that it draws something,
+// and that the surface triangles, which never overlap, come out the same through every depth test
+bool testPatchRenderer(const std::vector<Point3> &net, long width, long height) {
+    ControlPoints patch;
+    patch.vertices = net;
+    RenderParameters parameters(&patch);
+    parameters.bezierEnabled = true;
+    parameters.orthoProjection = false;
+    parameters.rotationMatrix.SetRotation(Vector3(1.0f, 0.5f, 0.0f), 0.6f);
+
+    PatchRenderer renderer(&patch, &parameters);
+    renderer.Resize(width, height);
+    auto render = [&]() {
+        renderer.Render();
+        return std::vector<RGBAValue>(renderer.frameBuffer.block, renderer.frameBuffer.block + width * height);
+    };
+    auto nDiffering = [](const std::vector<RGBAValue> &a, const std::vector<RGBAValue> &b) {
+        long n = 0;
+        for (size_t i = 0; i < a.size(); i++)
+            n += a[i].red != b[i].red || a[i].green != b[i].green || a[i].blue != b[i].blue;
+        return n;
+    };
+
+    long nUnrepeatable = 0, nMeshDiffering = 0, nDrawn = 0;
+    for (int renderer = 0; renderer < N_SURFACE_RENDERERS; renderer++)
+        for (int mode = 0; mode < N_FRAGMENT_RESOLVE_MODES; mode++) {
+            parameters.surfaceRenderer = (SurfaceRenderer)renderer;
+            parameters.fragmentResolveMode = (FragmentResolveMode)mode;
+            std::vector<RGBAValue> first = render(), second = render();
+            nUnrepeatable += nDiffering(first, second);
+        }
+
+    // just the mesh, so no two fragments at a pixel are ever at the same depth
+    parameters.planesEnabled = parameters.netEnabled = parameters.verticesEnabled = false;
+    parameters.surfaceRenderer = TRIANGLE_MESH;
+    parameters.fragmentResolveMode = DEPTH_BUFFER;
+    std::vector<RGBAValue> reference = render();
+    for (const RGBAValue &pixel : reference)
+        nDrawn += pixel.green == 127;
+    for (FragmentResolveMode mode : { ATOMIC_DEPTH_BUFFER, TILED_DEPTH_BUFFER }) {
+        parameters.fragmentResolveMode = mode;
+        nMeshDiffering += nDiffering(reference, render());
+    }
+
+    bool passed = nUnrepeatable == 0 && nMeshDiffering == 0 && nDrawn > 0;
+    std::cout << (passed ? "PASS" : "FAIL") << " patch renderer at " << width << " x " << height << ": " << nDrawn << " surface pixels, "
+              << nUnrepeatable << " differ between repeated frames, " << nMeshDiffering << " differ between depth tests" << std::endl;
+    return passed;
+}
+
+// draws just the control point markers with the Painter's algorithm, with and without blending their
+// edges, and checks that only pixels around the markers change, each to between the clear colour and
+// a marker's colour, and that the other resolve modes leave the markers as they were
+bool testAntialiasedMarkers(const std::vector<Point3> &net, long width, long height) {
+    ControlPoints patch;
+    patch.vertices = net;
+    RenderParameters parameters(&patch);
+    parameters.planesEnabled = parameters.netEnabled = parameters.bezierEnabled = false;
+    parameters.orthoProjection = false;
+
+    PatchRenderer renderer(&patch, &parameters);
+    renderer.Resize(width, height);
+    auto render = [&](FragmentResolveMode mode, bool antialiased) {
+        parameters.fragmentResolveMode = mode;
+        parameters.antialiasedMarkers = antialiased;
+        renderer.Render();
+        return std::vector<RGBAValue>(renderer.frameBuffer.block, renderer.frameBuffer.block + width * height);
+    };
+    auto same = [](const RGBAValue &a, const RGBAValue &b) { return a.red == b.red && a.green == b.green && a.blue == b.blue; };
+
+    std::vector<RGBAValue> hard = render(PAINTERS_ALGORITHM, false), smooth = render(PAINTERS_ALGORITHM, true);
+    RGBAValue clear = hard[0];
+
+    // the range of each channel over the clear colour and the markers' colours
+    int low[3] = { clear.red, clear.green, clear.blue }, high[3] = { clear.red, clear.green, clear.blue };
+    for (const RGBAValue &pixel : hard) {
+        int channels[3] = { pixel.red, pixel.green, pixel.blue };
+        for (int c = 0; c < 3; c++) {
+            low[c] = std::min(low[c], channels[c]);
+            high[c] = std::max(high[c], channels[c]);
+        }
+    }
+
+    long nBlended = 0, nOutOfRange = 0, nOtherModesDiffering = 0;
+    for (long i = 0; i < width * height; i++) {
+        if (same(hard[i], smooth[i]))
+            continue;
+        nBlended++;
+        // a blended pixel is never far from a marker
+        bool nearMarker = false;
+        long x = i % width, y = i / width;
+        for (long dy = -1; dy <= 1; dy++)
+            for (long dx = -1; dx <= 1; dx++)
+                if (x + dx >= 0 && x + dx < width && y + dy >= 0 && y + dy < height)
+                    nearMarker |= !same(hard[(y + dy) * width + x + dx], clear);
+        int channels[3] = { smooth[i].red, smooth[i].green, smooth[i].blue };
+        for (int c = 0; c < 3; c++)
+            nearMarker &= channels[c] >= low[c] && channels[c] <= high[c];
+        nOutOfRange += !nearMarker;
+    }
+    for (FragmentResolveMode mode : { DEPTH_BUFFER, ATOMIC_DEPTH_BUFFER, TILED_DEPTH_BUFFER }) {
+        std::vector<RGBAValue> modeHard = render(mode, false), modeSmooth = render(mode, true);
+        for (long i = 0; i < width * height; i++)
+            nOtherModesDiffering += !same(modeHard[i], modeSmooth[i]);
+    }
+
+    bool passed = nBlended > 0 && nOutOfRange == 0 && nOtherModesDiffering == 0;
+    std::cout << (passed ? "PASS" : "FAIL") << " anti-aliased markers at " << width << " x " << height << ": " << nBlended << " pixels blended, "
+              << nOutOfRange << " away from the markers or out of range, " << nOtherModesDiffering << " changed in the other resolve modes" << std::endl;
+    return passed;
+}
+
+// counts how many times each pixel is written by the line rasterizer
+struct LineCounter {
+    long width;
+    std::vector<int> counts;
+    long nCalls;
+    void operator()(float x, float y, float) { counts[(long)y * width + (long)x]++; nCalls++; }
+};
+
+// checks that a line writes one fragment per pixel along its longer axis,
+// never writes a pixel twice, and does no work for the part off screen
+bool testLine(float x0, float y0, float x1, float y1) {
+    long width = 64, height = 48;
+    LineCounter line{ width, std::vector<int>(width * height, 0), 0 };
+    rasterizeLine(Point3(x0, y0, 0.0f), Point3(x1, y1, 0.0f), width, height, line);
+
+    int doubles = 0, covered = 0;
+    for (int count : line.counts) {
+        covered += count > 0;
+        doubles += count > 1;
+    }
+
+    // pixels the longer axis crosses inside the viewport, give or take the ends
+    bool xMajor = std::fabs(x1 - x0) >= std::fabs(y1 - y0);
+    float majorStart = xMajor ? x0 : y0, majorEnd = xMajor ? x1 : y1, majorSize = xMajor ? width : height;
+    float onScreen = std::fmin(std::fmax(majorStart, majorEnd), majorSize) - std::fmax(std::fmin(majorStart, majorEnd), 0.0f);
+    long maxCalls = (long)std::ceil(onScreen) + 2;
+
+    bool passed = doubles == 0 && covered > 0 && line.nCalls <= maxCalls && covered >= onScreen - 1;
+    std::cout << (passed ? "PASS" : "FAIL") << " line (" << x0 << ", " << y0 << ") to (" << x1 << ", " << y1 << "): " << covered << " pixels covered, "
+              << doubles << " written twice, " << line.nCalls << " fragments" << std::endl;
+    return passed;
+}
+
+// checks that Liang-Barsky keeps segments inside as they are, rejects those outside,
+// and trims those partly outside so both ends land on the boundary
+bool testClipLine() {
+    Homogeneous4 insideStart(-0.5f, 0.2f, 0.1f, 1.0f), insideEnd(0.5f, -0.2f, -0.1f, 1.0f);
+    bool keepsInside = clipLine(insideStart, insideEnd) && insideStart.x == -0.5f && insideEnd.x == 0.5f;
+
+    Homogeneous4 outsideStart(2.0f, 0.0f, 0.0f, 1.0f), outsideEnd(3.0f, 5.0f, 0.0f, 1.0f);
+    bool rejectsOutside = !clipLine(outsideStart, outsideEnd);
+
+    // crosses the whole volume along x, and runs behind the eye in w
+    Homogeneous4 start(-4.0f, 0.5f, 0.0f, 2.0f), end(4.0f, 0.5f, 0.0f, 2.0f);
+    bool trimsCrossing = clipLine(start, end) && std::fabs(start.x + 2.0f) < 1e-5f && std::fabs(end.x - 2.0f) < 1e-5f;
+    Homogeneous4 front(0.0f, 0.0f, 0.5f, 1.0f), behind(0.0f, 0.0f, -3.0f, -1.0f);
+    bool trimsBehind = clipLine(front, behind) && behind.w > 0.0f && std::fabs(behind.z + behind.w) < 1e-5f;
+
+    bool passed = keepsInside && rejectsOutside && trimsCrossing && trimsBehind;
+    std::cout << (passed ? "PASS" : "FAIL") << " line clipping: inside " << keepsInside << ", outside " << rejectsOutside
+              << ", crossing " << trimsCrossing << ", behind the eye " << trimsBehind << std::endl;
+    return passed;
+}
+
+// area of a polygon in clip space x and y, for polygons with w = 1
+static float polygonArea(const ClipVertex *vertices, int nVertices) {
+    float area = 0.0f;
+    for (int i = 0; i < nVertices; i++) {
+        const Homogeneous4 &a = vertices[i].position, &b = vertices[(i + 1) % nVertices].position;
+        area += a.x * b.y - a.y * b.x;
+    }
+    return std::fabs(area) / 2.0f;
+}
+
+// checks that Sutherland-Hodgman leaves quads inside alone, removes those outside,
+// and cuts those crossing the boundary down to the part inside, with the
+// patch parameters interpolated onto the new vertices
+bool testClipPolygon() {
+    ClipVertex clipped[MAX_CLIP_VERTICES];
+
+    ClipVertex inside[4] = {
+        ClipVertex{ Homogeneous4(-0.5f, -0.5f, 0.0f, 1.0f), 0.0f, 0.0f }, ClipVertex{ Homogeneous4(0.5f, -0.5f, 0.0f, 1.0f), 0.0f, 1.0f },
+        ClipVertex{ Homogeneous4(0.5f, 0.5f, 0.0f, 1.0f), 1.0f, 1.0f }, ClipVertex{ Homogeneous4(-0.5f, 0.5f, 0.0f, 1.0f), 1.0f, 0.0f } };
+    bool keepsInside = clipPolygon(inside, 4, clipped) == 4 && std::fabs(polygonArea(clipped, 4) - 1.0f) < 1e-6f;
+
+    ClipVertex outside[4] = {
+        ClipVertex{ Homogeneous4(1.5f, -0.5f, 0.0f, 1.0f), 0.0f, 0.0f }, ClipVertex{ Homogeneous4(2.5f, -0.5f, 0.0f, 1.0f), 0.0f, 1.0f },
+        ClipVertex{ Homogeneous4(2.5f, 0.5f, 0.0f, 1.0f), 1.0f, 1.0f }, ClipVertex{ Homogeneous4(1.5f, 0.5f, 0.0f, 1.0f), 1.0f, 0.0f } };
+    bool rejectsOutside = clipPolygon(outside, 4, clipped) == 0;
+
+    // runs off the left and the top, so is cut by two planes into the square from (-1, -0.5) to (0.5, 1)
+    ClipVertex crossing[4] = {
+        ClipVertex{ Homogeneous4(-2.0f, -0.5f, 0.0f, 1.0f), 0.0f, 0.0f }, ClipVertex{ Homogeneous4(0.5f, -0.5f, 0.0f, 1.0f), 0.0f, 1.0f },
+        ClipVertex{ Homogeneous4(0.5f, 2.0f, 0.0f, 1.0f), 1.0f, 1.0f }, ClipVertex{ Homogeneous4(-2.0f, 2.0f, 0.0f, 1.0f), 1.0f, 0.0f } };
+    int nCrossing = clipPolygon(crossing, 4, clipped);
+    bool allInside = nCrossing > 0;
+    bool parametersFollow = true;
+    for (int i = 0; i < nCrossing; i++) {
+        const Homogeneous4 &p = clipped[i].position;
+        allInside &= p.x >= -1.0f - 1e-6f && p.x <= 1.0f + 1e-6f && p.y >= -1.0f - 1e-6f && p.y <= 1.0f + 1e-6f;
+        // the parameters are linear in x and y across this quad
+        parametersFollow &= std::fabs(clipped[i].t - (p.x + 2.0f) / 2.5f) < 1e-5f && std::fabs(clipped[i].s - (p.y + 0.5f) / 2.5f) < 1e-5f;
+    }
+    float area = polygonArea(clipped, nCrossing);
+    bool trimsCrossing = allInside && parametersFollow && std::fabs(area - 1.5f * 1.5f) < 1e-5f;
+
+    bool passed = keepsInside && rejectsOutside && trimsCrossing;
+    std::cout << (passed ? "PASS" : "FAIL") << " polygon clipping: inside " << keepsInside << ", outside " << rejectsOutside
+              << ", crossing " << trimsCrossing << " (" << nCrossing << " vertices, area " << area << ")" << std::endl;
+    return passed;
+}
+
+// checks that subdividing a patch in front of the camera gives leaves that
+// are flat enough and together cover the whole (s, t) square
+bool testSubdivision(const Homogeneous4 clipNet[16], float width, float height, float flatness) {
+    std::vector<PatchLeaf> leaves;
+    subdividePatch(clipNet, width, height, flatness, leaves);
+
+    double parameterArea = 0.0;
+    for (const PatchLeaf &leaf : leaves)
+        parameterArea += (double)(leaf.s1 - leaf.s0) * (leaf.t1 - leaf.t0);
+
+    bool passed = !leaves.empty() && std::fabs(parameterArea - 1.0) < 1e-6;
+    std::cout << (passed ? "PASS" : "FAIL") << " subdivision at " << width << " x " << height << ": " << leaves.size()
+              << " leaves covering " << parameterArea << " of the parameter square" << std::endl;
+    return passed;
+}
+
+int main() {
+    bool passed = true;
+
+    // one row of the patch in input/patch.txt
+    Homogeneous4 row[4] = {
+        Homogeneous4(-3.0f, 1.0f, 4.01f),
+        Homogeneous4(-1.0f, 1.0f, 4.01f),
+        Homogeneous4(1.0f, 1.0f, 4.01f),
+        Homogeneous4(3.0f, 1.0f, 4.01f) };
+
+    // a column of it, which is the curved direction
+    Homogeneous4 column[4] = {
+        Homogeneous4(-1.0f, 3.0f, 0.01f),
+        Homogeneous4(-1.0f, 1.0f, 4.01f),
+        Homogeneous4(-1.0f, -1.0f, -4.01f),
+        Homogeneous4(-1.0f, -3.0f, 0.01f) };
+
+    // a clip space curve with w varying, as the renderer uses them
+    Homogeneous4 clipSpace[4] = {
+        Homogeneous4(-9.5f, 7.25f, 3.0f, 8.0f),
+        Homogeneous4(6.0f, -2.5f, -9.75f, 4.0f),
+        Homogeneous4(-4.0f, 9.0f, 1.5f, 10.0f),
+        Homogeneous4(8.75f, -6.0f, 5.5f, 1.0f) };
+
+    // the renderer's 1000 steps, plus a short run and one longer than the re-seed interval
+    int stepCounts[3] = { 1000, 10, 4096 };
+    for (int n : stepCounts) {
+        passed &= testForwardDifferences(row, n);
+        passed &= testForwardDifferences(column, n);
+        passed &= testForwardDifferences(clipSpace, n);
+    }
+
+    // the whole control net from input/patch.txt
+    Homogeneous4 net[16] = {
+        Homogeneous4(-3.0f, 3.0f, 0.01f), Homogeneous4(-1.0f, 3.0f, 0.01f), Homogeneous4(1.0f, 3.0f, 0.01f), Homogeneous4(3.0f, 3.0f, 0.01f),
+        Homogeneous4(-3.0f, 1.0f, 4.01f), Homogeneous4(-1.0f, 1.0f, 4.01f), Homogeneous4(1.0f, 1.0f, 4.01f), Homogeneous4(3.0f, 1.0f, 4.01f),
+        Homogeneous4(-3.0f, -1.0f, -4.01f), Homogeneous4(-1.0f, -1.0f, -4.01f), Homogeneous4(1.0f, -1.0f, -4.01f), Homogeneous4(3.0f, -1.0f, -4.01f),
+        Homogeneous4(-3.0f, -3.0f, 0.01f), Homogeneous4(-1.0f, -3.0f, 0.01f), Homogeneous4(1.0f, -3.0f, 0.01f), Homogeneous4(3.0f, -3.0f, 0.01f) };
+    passed &= testPatchRows(net, 1000);
+    passed &= testBasisTable(net, 1000);
+    passed &= testBasisTable(net, 37);
+
+    // the net seen from the front at a few sizes, with and without perspective
+    // (x and y scaled into clip space, w growing with depth to foreshorten it)
+    for (float scale : { 0.05f, 0.1f, 0.2f }) {
+        Homogeneous4 orthographic[16], perspective[16];
+        for (int i = 0; i < 16; i++) {
+            orthographic[i] = Homogeneous4(net[i].x * scale, net[i].y * scale, 0.0f, 1.0f);
+            perspective[i] = Homogeneous4(net[i].x * scale, net[i].y * scale, 0.0f, 1.0f + 0.1f * net[i].z);
+        }
+        passed &= testAdaptiveSampling(orthographic, 640.0f, 480.0f, 1.5f);
+        passed &= testAdaptiveSampling(perspective, 1600.0f, 720.0f, 1.5f);
+        // a viewport big enough for the patch to need more than MAX_SAMPLE_STEPS
+        passed &= testAdaptiveSampling(orthographic, 4096.0f, 4096.0f, 1.5f, true);
+        passed &= testAdaptiveSampling(perspective, 4096.0f, 4096.0f, 1.5f, true);
+        passed &= testSubdivision(perspective, 1600.0f, 720.0f, 0.25f);
+        passed &= testMeshCoverage(perspective, 1600, 720, 97);
+        passed &= testTileBinner(perspective, 200, 150, 23);
+    }
+
+    // zoomed in, so most of the patch is off screen but still has to be sampled as finely
+    {
+        Homogeneous4 zoomed[16];
+        for (int i = 0; i < 16; i++)
+            zoomed[i] = Homogeneous4(net[i].x * 0.6f, net[i].y * 0.6f, 0.0f, 1.0f);
+        passed &= testAdaptiveSampling(zoomed, 640.0f, 480.0f, 1.5f);
+    }
+
+    // unevenly spaced control points, so the curves move much faster near one end than
+    // their length suggests: rows bunched at one side, and columns that double back
+    {
+        float rowX[4] = { -0.5f, -0.5f, -0.5f, 0.5f }, columnY[4] = { 0.5f, -0.5f, -0.5f, 0.5f };
+        Homogeneous4 uneven[16], unevenPerspective[16], unevenForeshortened[16];
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++) {
+                // shear the columns a little, so the rows aren't all the same
+                float x = rowX[j] + 0.1f * i, y = columnY[i] * (0.6f + 0.1f * j);
+                uneven[i * 4 + j] = Homogeneous4(x, y, 0.0f, 1.0f);
+                // with w running from 1 to 3 across the rows, once keeping the same outline on
+                // screen and once tilted steeply away from the camera so the far side shrinks
+                float w = 1.0f + 2.0f * j / 3.0f;
+                unevenPerspective[i * 4 + j] = Homogeneous4(x * w * 0.8f, y * w * 0.8f, 0.0f, w);
+                unevenForeshortened[i * 4 + j] = Homogeneous4(x * 0.8f, y * 0.8f, 0.0f, w);
+            }
+        passed &= testAdaptiveSampling(uneven, 640.0f, 480.0f, 1.5f);
+        passed &= testAdaptiveSampling(unevenPerspective, 640.0f, 480.0f, 1.5f);
+        passed &= testAdaptiveSampling(unevenForeshortened, 640.0f, 480.0f, 1.5f);
+    }
+
+    // an axis aligned square, with pixel centres right on its edges, and a skewed quad
+    passed &= testWatertightTriangles(8.5f, 8.5f, 8.5f, 40.5f, 40.5f, 40.5f, 40.5f, 8.5f);
+    passed &= testWatertightTriangles(3.2f, 10.7f, 20.1f, 60.3f, 61.9f, 45.5f, 30.4f, 1.1f);
+
+    // shallow, steep and backwards lines, and ones running far off screen on either side
+    passed &= testLine(2.5f, 3.5f, 60.2f, 20.7f);
+    passed &= testLine(10.1f, 45.9f, 14.3f, 0.4f);
+    passed &= testLine(-5000.0f, 30.0f, 5000.0f, 10.0f);
+    passed &= testLine(31.0f, 100000.0f, 33.0f, -100000.0f);
+
+    // small triangles the kernel fills, and ones too big for it that every level fills the same way
+    passed &= testTriangleKernel(5.0f);
+    passed &= testTriangleKernel(60.0f);
+    passed &= testTriangleKernel(300.0f);
+
+    passed &= testMarkerStamp(0);
+    passed &= testMarkerStamp(5);
+    passed &= testMarkerStamp(17);
+
+    passed &= testFragmentShade(255);
+
+    // fewer frames than the ring buffer holds, and enough to go round it several times
+    passed &= testFrameTimer(100);
+    passed &= testFrameTimer(1000);
+
+    // a handful of fragments, and enough for the sort to be split between threads
+    passed &= testFragmentArena(1000);
+    passed &= testFragmentSorter(37, 23, 3000);
+    passed &= testFragmentSorter(640, 480, 500000);
+
+    std::vector<Point3> netPoints;
+    for (const Homogeneous4 &point : net)
+        netPoints.push_back(Point3(point.x, point.y, point.z));
+    passed &= testPatchRenderer(netPoints, 320, 240);
+    passed &= testFrameTracer(netPoints);
+    passed &= testAntialiasedMarkers(netPoints, 320, 240);
+
+    passed &= testClipLine();
+    passed &= testClipPolygon();
+
+    // the clip space curve runs outside the frustum, so some samples are clipped,
+    // and an odd sample count leaves a tail for the scalar code
+    passed &= testPatchKernel(clipSpace, 1000);
+    passed &= testPatchKernel(clipSpace, 13);
+
+    // the row shrunk to lie inside the view volume
+    Homogeneous4 insideRow[4];
+    for (int i = 0; i < 4; i++)
+        insideRow[i] = Homogeneous4(row[i].x * 0.2f, row[i].y * 0.2f, row[i].z * 0.2f, 1.0f);
+    passed &= testUnclippedRow(insideRow, 1000);
+    passed &= testUnclippedRow(insideRow, 13);
+
+    // a perspective camera that scales the net into clip space and pushes it back from the eye
+    Matrix4 mvp;
+    mvp.coordinates[0][0] = 0.2f;
+    mvp.coordinates[1][1] = 0.25f;
+    mvp.coordinates[2][2] = 0.1f;
+    mvp.coordinates[3][2] = 0.05f;
+    mvp.coordinates[3][3] = 1.0f;
+    passed &= testSurfaceCache(net, mvp, 1000);
+    passed &= testSurfaceCache(net, mvp, 37);
+    passed &= testSurfaceCacheUpdate(net, 1000);
+    passed &= testSurfaceCacheUpdate(net, 37);
+
+    return passed ? 0 : 1;
+}
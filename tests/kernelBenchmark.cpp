@@ -0,0 +1,107 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include "../BezierPatchWindowRelease/Homogeneous4.h"
+#include "../BezierPatchWindowRelease/Matrix4.h"
+#include "../BezierPatchWindowRelease/BezierEvaluation.h"
+#include "../BezierPatchWindowRelease/PatchKernel.h"
+
+// Microbenchmark comparing the SIMD patch kernel with the original per-sample
+// path of five bezier() evaluations and a transformPoint() for every sample.
+// Both evaluate the 1001 x 1001 grid the renderer uses and report samples per second.
+
+#define N_STEPS 1000
+#define N_REPEATS 5
+
+// the control net from input/patch.txt
+static const float patch[16][3] = {
+    { -3.0f,  3.0f,  0.01f }, { -1.0f,  3.0f,  0.01f }, { 1.0f,  3.0f,  0.01f }, { 3.0f,  3.0f,  0.01f },
+    { -3.0f,  1.0f,  4.01f }, { -1.0f,  1.0f,  4.01f }, { 1.0f,  1.0f,  4.01f }, { 3.0f,  1.0f,  4.01f },
+    { -3.0f, -1.0f, -4.01f }, { -1.0f, -1.0f, -4.01f }, { 1.0f, -1.0f, -4.01f }, { 3.0f, -1.0f, -4.01f },
+    { -3.0f, -3.0f,  0.01f }, { -1.0f, -3.0f,  0.01f }, { 1.0f, -3.0f,  0.01f }, { 3.0f, -3.0f,  0.01f } };
+
+// runs one pass over the grid N_REPEATS times and returns the median samples per second
+template <typename Pass>
+double samplesPerSecond(Pass pass) {
+    std::vector<double> rates;
+    for (int repeat = 0; repeat < N_REPEATS; repeat++) {
+        auto start = std::chrono::steady_clock::now();
+        pass();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        rates.push_back((N_STEPS + 1.0) * (N_STEPS + 1.0) / elapsed.count());
+    }
+    std::sort(rates.begin(), rates.end());
+    return rates[rates.size() / 2];
+}
+
+int main() {
+    float width = 1600.0f, height = 720.0f;
+
+    // perspective projection and view set up the same way as BezierPatchRenderWidget::paintGL()
+    float aspectRatio = width / height, _near = 0.01f, _far = 200.0f;
+    float left = -aspectRatio * 0.01f, right = aspectRatio * 0.01f, bottom = -0.01f, top = 0.01f;
+    Matrix4 projectionMatrix;
+    projectionMatrix.SetIdentity();
+    projectionMatrix[0][0] = (2.0f * _near) / (right - left);
+    projectionMatrix[1][1] = (2.0f * _near) / (top - bottom);
+    projectionMatrix[2][2] = -(_far + _near) / (_far - _near);
+    projectionMatrix[3][3] = 0.0f;
+    projectionMatrix[3][2] = -1.0f;
+    projectionMatrix[2][3] = -(2.0f * _far * _near) / (_far - _near);
+    Matrix4 viewMatrix;
+    viewMatrix.SetIdentity();
+    viewMatrix.SetTranslation(Vector3(0.0f, 0.0f, -7.6f));
+    Matrix4 mvpMatrix = projectionMatrix * viewMatrix;
+
+    Homogeneous4 controlPoints[16], clipControlPoints[16];
+    for (int i = 0; i < 16; i++) {
+        controlPoints[i] = Homogeneous4(patch[i][0], patch[i][1], patch[i][2]);
+        clipControlPoints[i] = mvpMatrix * controlPoints[i];
+    }
+
+    // somewhere to put the results so the work is not optimised away
+    std::vector<float> screenX(N_STEPS + 1), screenY(N_STEPS + 1), screenZ(N_STEPS + 1);
+    float checksum = 0.0f;
+
+    // the original path: evaluate in world space with bezier(), then transformPoint()
+    double reference = samplesPerSecond([&]() {
+        for (int s = 0; s <= N_STEPS; s++) {
+            for (int tIndex = 0; tIndex <= N_STEPS; tIndex++) {
+                float t = (float)tIndex / N_STEPS;
+                Homogeneous4 bezier1 = bezierPoint(t, controlPoints[0], controlPoints[1], controlPoints[2], controlPoints[3]);
+                Homogeneous4 bezier2 = bezierPoint(t, controlPoints[4], controlPoints[5], controlPoints[6], controlPoints[7]);
+                Homogeneous4 bezier3 = bezierPoint(t, controlPoints[8], controlPoints[9], controlPoints[10], controlPoints[11]);
+                Homogeneous4 bezier4 = bezierPoint(t, controlPoints[12], controlPoints[13], controlPoints[14], controlPoints[15]);
+                Homogeneous4 finalPoint = bezierPoint((float)s / N_STEPS, bezier1, bezier2, bezier3, bezier4);
+                Point3 screenPoint = clipToViewport(mvpMatrix * finalPoint, width, height);
+                screenX[tIndex] = screenPoint.x;
+            }
+            checksum += screenX[s];
+        }
+    });
+    std::cout << std::setw(28) << std::left << "bezier() + transformPoint()" << std::setprecision(4) << reference / 1e6 << " M samples/s" << std::endl;
+
+    // the kernel at every level this CPU supports
+    BernsteinTable table;
+    table.Resize(N_STEPS);
+    for (int level = KERNEL_SCALAR; level <= DetectKernelLevel(); level++) {
+        double rate = samplesPerSecond([&]() {
+            for (int s = 0; s <= N_STEPS; s++) {
+                Homogeneous4 rowControlPoints[4];
+                for (int j = 0; j < 4; j++)
+                    rowControlPoints[j] = bezierCombine(table[s], clipControlPoints[j], clipControlPoints[4 + j], clipControlPoints[8 + j], clipControlPoints[12 + j]);
+                evaluatePatchRow(KernelLevel(level), rowControlPoints, table, width, height, screenX.data(), screenY.data(), screenZ.data());
+                checksum += screenX[s];
+            }
+        });
+        std::cout << std::setw(28) << std::left << (std::string(KernelLevelName(KernelLevel(level))) + " kernel") << std::setprecision(4) << rate / 1e6
+                  << " M samples/s (" << std::setprecision(3) << rate / reference << "x)" << std::endl;
+    }
+
+    // print the checksum so none of the passes can be skipped
+    std::cout << "checksum " << checksum << std::endl;
+    return 0;
+}
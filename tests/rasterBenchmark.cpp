@@ -0,0 +1,199 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <limits>
+#include <algorithm>
+
+#include "../BezierPatchWindowRelease/Homogeneous4.h"
+#include "../BezierPatchWindowRelease/Matrix4.h"
+#include "../BezierPatchWindowRelease/BezierEvaluation.h"
+#include "../BezierPatchWindowRelease/PatchKernel.h"
+#include "../BezierPatchWindowRelease/Tessellation.h"
+#include "../BezierPatchWindowRelease/Rasterizer.h"
+#include "../BezierPatchWindowRelease/RGBAImage.h"
+#include "../BezierPatchWindowRelease/DepthBuffer.h"
+#include "../BezierPatchWindowRelease/ShadeBuffer.h"
+#include "../BezierPatchWindowRelease/TileBinner.h"
+
+// Benchmark comparing the point-splat surface renderer with the triangle mesh renderer.
+// Each draws the patch from input/patch.txt filling most of a perspective view, into a
+// depth buffer and shade buffer, then shading the framebuffer from the fragments left nearest,
+// as the DEPTH_BUFFER resolve mode does, at three window sizes.
+// It reports the median time per frame and how many pixels each left covered, so the
+// holes the point splats leave show up as the gap to the mesh.
+// The mesh is drawn on one thread with the scalar triangle fill and with the SIMD one,
+// and once binned into screen tiles on every thread and resolved a tile per thread as the
+// TILED_DEPTH_BUFFER mode does (which includes clearing the buffers, left out of the other timings).
+
+#define N_REPEATS 5
+
+// the control net from input/patch.txt
+static const float patch[16][3] = {
+    { -3.0f,  3.0f,  0.01f }, { -1.0f,  3.0f,  0.01f }, { 1.0f,  3.0f,  0.01f }, { 3.0f,  3.0f,  0.01f },
+    { -3.0f,  1.0f,  4.01f }, { -1.0f,  1.0f,  4.01f }, { 1.0f,  1.0f,  4.01f }, { 3.0f,  1.0f,  4.01f },
+    { -3.0f, -1.0f, -4.01f }, { -1.0f, -1.0f, -4.01f }, { 1.0f, -1.0f, -4.01f }, { 3.0f, -1.0f, -4.01f },
+    { -3.0f, -3.0f,  0.01f }, { -1.0f, -3.0f,  0.01f }, { 1.0f, -3.0f,  0.01f }, { 3.0f, -3.0f,  0.01f } };
+
+// depth tests each fragment into the depth buffer and keeps the survivors' (s, t) to be shaded
+struct FragmentWriter {
+    DepthBuffer &depthBuffer;
+    ShadeBuffer &shadeBuffer;
+    void operator()(float x, float y, float z, float s, float t) {
+        Point3 point(x, y, z);
+        if (depthBuffer.depthTest(point))
+            shadeBuffer[(int)y][(int)x] = FragmentShade::Surface(s, t);
+    }
+};
+
+// the colour of a fragment, as the renderer shades it
+static RGBAValue shadeFragment(FragmentShade shade) {
+    return shade.IsSurface() ? RGBAValue(255.0f * shade.S(), 255.0f / 2, 255.0f * shade.T(), 255.0f) : shade.Colour();
+}
+
+// one renderer's results at one size
+struct FrameResult {
+    double milliseconds;
+    long pixelsCovered;
+};
+
+// runs a frame N_REPEATS times and returns the median time and the coverage of the last
+template <typename Frame>
+FrameResult timeFrame(DepthBuffer &depthBuffer, ShadeBuffer &shadeBuffer, Frame frame) {
+    std::vector<double> times;
+    for (int repeat = 0; repeat < N_REPEATS; repeat++) {
+        depthBuffer.clear(std::numeric_limits<float>::max());
+        shadeBuffer.clear(FragmentShade::Flat(RGBAValue(204.0f, 204.0f, 153.0f, 255.0f)));
+        auto start = std::chrono::steady_clock::now();
+        frame();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        times.push_back(elapsed.count());
+    }
+    std::sort(times.begin(), times.end());
+
+    long covered = 0;
+    for (long y = 0; y < depthBuffer.height; y++)
+        for (long x = 0; x < depthBuffer.width; x++)
+            covered += depthBuffer[y][x] != std::numeric_limits<float>::max();
+    return FrameResult{ times[times.size() / 2], covered };
+}
+
+// perspective projection and view set up the same way as BezierPatchRenderWidget::paintGL()
+static Matrix4 perspectiveMvp(float width, float height) {
+    float aspectRatio = width / height, _near = 0.01f, _far = 200.0f;
+    float left, right, bottom, top;
+    if (aspectRatio > 1.0f) {
+        left = -aspectRatio * 0.01f; right = aspectRatio * 0.01f; bottom = -0.01f; top = 0.01f;
+    } else {
+        left = -0.01f; right = 0.01f; bottom = -aspectRatio * 0.01f; top = aspectRatio * 0.01f;
+    }
+    Matrix4 projectionMatrix;
+    projectionMatrix.SetIdentity();
+    projectionMatrix[0][0] = (2.0f * _near) / (right - left);
+    projectionMatrix[1][1] = (2.0f * _near) / (top - bottom);
+    projectionMatrix[2][2] = -(_far + _near) / (_far - _near);
+    projectionMatrix[3][3] = 0.0f;
+    projectionMatrix[3][2] = -1.0f;
+    projectionMatrix[2][3] = -(2.0f * _far * _near) / (_far - _near);
+    Matrix4 viewMatrix;
+    viewMatrix.SetIdentity();
+    viewMatrix.SetTranslation(Vector3(0.0f, 0.0f, -7.6f));
+    return projectionMatrix * viewMatrix;
+}
+
+int main() {
+    long sizes[3][2] = { { 640, 480 }, { 1600, 720 }, { 4096, 4096 } };
+    KernelLevel level = DetectKernelLevel();
+
+    std::cout << std::setw(12) << std::left << "size" << std::setw(26) << "renderer" << std::setw(12) << "grid"
+              << std::setw(14) << "ms / frame" << "pixels covered" << std::endl;
+
+    for (auto &size : sizes) {
+        long width = size[0], height = size[1];
+        RGBAImage frameBuffer;
+        DepthBuffer depthBuffer;
+        ShadeBuffer shadeBuffer;
+        frameBuffer.Resize(width, height);
+        depthBuffer.Resize(width, height);
+        shadeBuffer.Resize(width, height);
+        FragmentWriter writer{ depthBuffer, shadeBuffer };
+
+        Matrix4 mvpMatrix = perspectiveMvp((float)width, (float)height);
+        Homogeneous4 clipControlPoints[16];
+        for (int i = 0; i < 16; i++)
+            clipControlPoints[i] = mvpMatrix * Homogeneous4(patch[i][0], patch[i][1], patch[i][2]);
+
+        float speedS = 0.0f, speedT = 0.0f;
+        projectedNetSpeeds(clipControlPoints, (float)width, (float)height, speedS, speedT);
+
+        TileBinner binner;
+        binner.Resize(width, height);
+        auto shade = [](FragmentShade fragmentShade) { return shadeFragment(fragmentShade); };
+
+        // points at the original fixed 1000 steps, points at 1.5 samples per pixel, and the mesh with 4 pixel edges
+        int meshStepsS = samplingSteps(speedS, 0.25f), meshStepsT = samplingSteps(speedT, 0.25f);
+        std::string simdMesh = std::string("triangle mesh, ") + KernelLevelName(level);
+        struct { std::string name; bool mesh, tiled; KernelLevel level; int nStepsS, nStepsT; } renderers[5] = {
+            { "points, fixed", false, false, KERNEL_SCALAR, 1000, 1000 },
+            { "points, adaptive", false, false, KERNEL_SCALAR, samplingSteps(speedS, 1.5f), samplingSteps(speedT, 1.5f) },
+            { "triangle mesh, scalar", true, false, KERNEL_SCALAR, meshStepsS, meshStepsT },
+            { simdMesh, true, false, level, meshStepsS, meshStepsT },
+            { "triangle mesh, tiled", true, true, level, meshStepsS, meshStepsT } };
+
+        for (auto &renderer : renderers) {
+            BernsteinTable sTable, tTable;
+            sTable.Resize(renderer.nStepsS);
+            tTable.Resize(renderer.nStepsT);
+            std::vector<Homogeneous4> grid;
+            std::vector<float> rowX(renderer.nStepsT + 1), rowY(renderer.nStepsT + 1), rowZ(renderer.nStepsT + 1);
+
+            FrameResult result = timeFrame(depthBuffer, shadeBuffer, [&]() {
+                if (renderer.tiled) {
+                    evaluatePatchGrid(clipControlPoints, sTable, tTable, grid);
+                    int rowLength = renderer.nStepsT + 1;
+                    binner.Clear();
+                    #pragma omp parallel for schedule(dynamic, 4)
+                    for (int s = 0; s < renderer.nStepsS; s++) {
+                        auto binTriangle = [&](const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2) { binner.AddTriangle(v0, v1, v2); };
+                        for (int t = 0; t < renderer.nStepsT; t++) {
+                            const Homogeneous4 *cell = &grid[s * rowLength + t];
+                            Homogeneous4 corners[4] = { cell[0], cell[1], cell[rowLength], cell[rowLength + 1] };
+                            triangulateQuad(corners, (float)s / renderer.nStepsS, (float)(s + 1) / renderer.nStepsS,
+                                            (float)t / renderer.nStepsT, (float)(t + 1) / renderer.nStepsT, width, height, binTriangle);
+                        }
+                    }
+                    binner.Resolve(level, frameBuffer, depthBuffer, FragmentShade::Flat(RGBAValue(204.0f, 204.0f, 153.0f, 255.0f)), shade);
+                } else if (renderer.mesh) {
+                    evaluatePatchGrid(clipControlPoints, sTable, tTable, grid);
+                    int rowLength = renderer.nStepsT + 1;
+                    for (int s = 0; s < renderer.nStepsS; s++)
+                        for (int t = 0; t < renderer.nStepsT; t++) {
+                            const Homogeneous4 *cell = &grid[s * rowLength + t];
+                            Homogeneous4 corners[4] = { cell[0], cell[1], cell[rowLength], cell[rowLength + 1] };
+                            rasterizeQuad(renderer.level, corners, (float)s / renderer.nStepsS, (float)(s + 1) / renderer.nStepsS,
+                                          (float)t / renderer.nStepsT, (float)(t + 1) / renderer.nStepsT, width, height, writer);
+                        }
+                } else {
+                    for (int s = 0; s <= renderer.nStepsS; s++) {
+                        Homogeneous4 rowControlPoints[4];
+                        for (int j = 0; j < 4; j++)
+                            rowControlPoints[j] = bezierCombine(sTable[s], clipControlPoints[j], clipControlPoints[4 + j], clipControlPoints[8 + j], clipControlPoints[12 + j]);
+                        evaluatePatchRow(level, rowControlPoints, tTable, (float)width, (float)height, rowX.data(), rowY.data(), rowZ.data());
+                        for (int t = 0; t <= renderer.nStepsT; t++)
+                            writer(rowX[t], rowY[t], rowZ[t], (float)s / renderer.nStepsS, (float)t / renderer.nStepsT);
+                    }
+                }
+
+                // the tiles shade themselves, the others are shaded in one pass over the screen
+                if (!renderer.tiled)
+                    shadeBuffer.resolve(frameBuffer, shade);
+            });
+
+            std::cout << std::setw(12) << std::left << (std::to_string(width) + "x" + std::to_string(height)) << std::setw(26) << renderer.name
+                      << std::setw(12) << (std::to_string(renderer.nStepsS) + "x" + std::to_string(renderer.nStepsT))
+                      << std::setw(14) << std::fixed << std::setprecision(2) << result.milliseconds << result.pixelsCovered << std::endl;
+        }
+    }
+    return 0;
+}
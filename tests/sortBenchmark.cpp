@@ -0,0 +1,87 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include "../BezierPatchWindowRelease/Point3.h"
+#include "../BezierPatchWindowRelease/FragmentArena.h"
+#include "../BezierPatchWindowRelease/FragmentSorter.h"
+
+// Microbenchmark comparing the radix sort of fragment keys with the std::sort of whole
+// fragments the Painter's algorithm used before it, on a million fragments spread over
+// a screen once and stacked several deep. Reports milliseconds per sort.
+
+#define N_FRAGMENTS 1000000
+#define N_REPEATS 5
+
+// the comparison the Painter's algorithm sorted with
+static bool lessFragment(const Fragment &left, const Fragment &right) {
+    if ((int)left.point.y > (int)right.point.y) return true;
+    if ((int)left.point.y < (int)right.point.y) return false;
+    if ((int)left.point.x < (int)right.point.x) return true;
+    if ((int)left.point.x > (int)right.point.x) return false;
+    return left.point.z > right.point.z;
+}
+
+// runs a pass N_REPEATS times and returns the median milliseconds it took
+template <typename Setup, typename Pass>
+double millisecondsPerPass(Setup setup, Pass pass) {
+    std::vector<double> times;
+    for (int repeat = 0; repeat < N_REPEATS; repeat++) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        pass();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        times.push_back(elapsed.count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main() {
+    std::cout << std::setw(12) << std::left << "size" << std::setw(16) << "per pixel" << std::setw(14) << "std::sort ms"
+              << std::setw(14) << "radix ms" << "speedup" << std::endl;
+
+    // about one fragment a pixel, then the same number stacked about eight deep
+    long sizes[2][2] = { { 1600, 720 }, { 400, 300 } };
+    long checksum = 0;
+    for (auto &size : sizes) {
+        long width = size[0], height = size[1];
+
+        // fragments at random pixels and depths, in the order the renderer would make them
+        std::vector<Fragment> fragments(N_FRAGMENTS), sorted;
+        unsigned int seed = 1;
+        auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+        for (Fragment &fragment : fragments)
+            fragment = Fragment{ Point3(width * random(), height * random(), 2.0f * random() - 1.0f), FragmentShade::Surface(random(), random()) };
+
+        double reference = millisecondsPerPass([&]() { sorted = fragments; }, [&]() {
+            std::sort(sorted.begin(), sorted.end(), lessFragment);
+        });
+        checksum += (long)sorted[N_FRAGMENTS / 2].point.x;
+
+        // making the keys is part of the cost, as the renderer has to do it every frame
+        FragmentSorter sorter;
+        sorter.Resize(width, height);
+        double radix = millisecondsPerPass([]() {}, [&]() {
+            sorter.Reserve(N_FRAGMENTS);
+            #pragma omp parallel for
+            for (long i = 0; i < N_FRAGMENTS; i++) {
+                sorter.keys[i] = sorter.Key(fragments[i].point);
+                sorter.payloads[i] = (uint32_t)i;
+            }
+            sorter.Sort();
+        });
+        checksum += (long)fragments[sorter.payloads[N_FRAGMENTS / 2]].point.x;
+
+        std::cout << std::setw(12) << std::left << (std::to_string(width) + "x" + std::to_string(height))
+                  << std::setw(16) << std::setprecision(3) << (double)N_FRAGMENTS / (width * height)
+                  << std::setw(14) << std::fixed << std::setprecision(2) << reference << std::setw(14) << radix
+                  << std::setprecision(1) << reference / radix << "x" << std::defaultfloat << std::endl;
+    }
+
+    // print the checksum so none of the passes can be skipped
+    std::cout << "checksum " << checksum << std::endl;
+    return 0;
+}
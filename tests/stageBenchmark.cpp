@@ -0,0 +1,183 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "../BezierPatchWindowRelease/Homogeneous4.h"
+#include "../BezierPatchWindowRelease/Matrix4.h"
+#include "../BezierPatchWindowRelease/BezierEvaluation.h"
+#include "../BezierPatchWindowRelease/ControlPoints.h"
+#include "../BezierPatchWindowRelease/RenderParameters.h"
+#include "../BezierPatchWindowRelease/PatchRenderer.h"
+#include "../BezierPatchWindowRelease/FragmentSorter.h"
+#include "../BezierPatchWindowRelease/ShadeBuffer.h"
+#include "../BezierPatchWindowRelease/AtomicFrameBuffer.h"
+#include "../BezierPatchWindowRelease/RGBAImage.h"
+
+// Benchmark suite timing each stage of the renderer on its own, to catch performance regressions:
+// the matrix and homogeneous point arithmetic, bezier() and transformPoint() per sample, sorting
+// a frame's fragments, shading the framebuffer from the depth tested modes, and clearing it.
+// Every stage is run N_REPEATS times, each time over a batch of items, and the median and 99th
+// percentile milliseconds per batch are reported with the median throughput in items per second.
+// Sizes are those of the application's 1600 x 720 window.
+
+#define N_REPEATS 101
+#define WIDTH 1600
+#define HEIGHT 720
+
+// the control net from input/patch.txt
+static const float patch[16][3] = {
+    { -3.0f,  3.0f,  0.01f }, { -1.0f,  3.0f,  0.01f }, { 1.0f,  3.0f,  0.01f }, { 3.0f,  3.0f,  0.01f },
+    { -3.0f,  1.0f,  4.01f }, { -1.0f,  1.0f,  4.01f }, { 1.0f,  1.0f,  4.01f }, { 3.0f,  1.0f,  4.01f },
+    { -3.0f, -1.0f, -4.01f }, { -1.0f, -1.0f, -4.01f }, { 1.0f, -1.0f, -4.01f }, { 3.0f, -1.0f, -4.01f },
+    { -3.0f, -3.0f,  0.01f }, { -1.0f, -3.0f,  0.01f }, { 1.0f, -3.0f,  0.01f }, { 3.0f, -3.0f,  0.01f } };
+
+// the colour of a fragment, as the renderer shades it
+static RGBAValue shadeFragment(FragmentShade shade) {
+    return shade.IsSurface() ? RGBAValue(255.0f * shade.S(), 255.0f / 2, 255.0f * shade.T(), 255.0f) : shade.Colour();
+}
+
+// times a stage, whose pass() handles nItems items; prints the median and 99th percentile milliseconds and the throughput
+template <typename Pass>
+void timeStage(const std::string &name, const std::string &unit, long nItems, Pass pass) {
+    std::vector<double> times;
+    for (int repeat = 0; repeat < N_REPEATS; repeat++) {
+        auto start = std::chrono::steady_clock::now();
+        pass();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        times.push_back(elapsed.count());
+    }
+    std::sort(times.begin(), times.end());
+    double median = times[times.size() / 2];
+    double p99 = times[(size_t)(0.99 * (times.size() - 1) + 0.5)];
+    std::cout << std::setw(28) << std::left << name << std::setw(12) << nItems << std::fixed << std::setprecision(3)
+              << std::setw(12) << median << std::setw(12) << p99 << std::setprecision(1) << std::setw(10) << nItems / median / 1000.0
+              << unit << "/s" << std::defaultfloat << std::endl;
+}
+
+int main() {
+    std::cout << std::setw(28) << std::left << "stage" << std::setw(12) << "items" << std::setw(12) << "median ms"
+              << std::setw(12) << "p99 ms" << "throughput (millions)" << std::endl;
+
+    // a pseudo-random stream, the same every run
+    unsigned int seed = 1;
+    auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+    // summed from every stage's results and printed, so none of them can be skipped
+    double checksum = 0.0;
+
+    // matrix products, as the camera setup does
+    const long nMatrices = 100000;
+    std::vector<Matrix4> matrices(64);
+    for (Matrix4 &matrix : matrices)
+        for (int row = 0; row < 4; row++)
+            for (int column = 0; column < 4; column++)
+                matrix[row][column] = random() - 0.5f;
+    timeStage("Matrix4 * Matrix4", "products", nMatrices, [&]() {
+        Matrix4 product = matrices[0];
+        for (long i = 0; i < nMatrices; i++) {
+            product = product * matrices[i & 63];
+            // keep the product from growing without bound
+            product[3][3] = 1.0f;
+        }
+        checksum += product[0][0];
+    });
+
+    // homogeneous point arithmetic, a multiply-add per item, as curve evaluation does
+    const long nPoints = 1000000;
+    std::vector<Homogeneous4> points(1024);
+    for (Homogeneous4 &point : points)
+        point = Homogeneous4(random(), random(), random(), 1.0f);
+    timeStage("Homogeneous4 multiply-add", "ops", nPoints, [&]() {
+        Homogeneous4 sum(0.0f, 0.0f, 0.0f, 0.0f);
+        for (long i = 0; i < nPoints; i++)
+            sum = sum * 0.5f + points[i & 1023];
+        checksum += sum.x;
+    });
+
+    // a full bezier() per sample, as the direct evaluation mode takes four of
+    Homogeneous4 controlPoints[16];
+    for (int i = 0; i < 16; i++)
+        controlPoints[i] = Homogeneous4(patch[i][0], patch[i][1], patch[i][2], 1.0f);
+    const long nCurvePoints = 1000000;
+    timeStage("bezier()", "samples", nCurvePoints, [&]() {
+        float sum = 0.0f;
+        for (long i = 0; i < nCurvePoints; i++) {
+            int row = (int)(i & 3) * 4;
+            sum += bezierPoint((float)(i % 1001) / 1000.0f, controlPoints[row], controlPoints[row + 1], controlPoints[row + 2], controlPoints[row + 3]).z;
+        }
+        checksum += sum;
+    });
+
+    // transformPoint() through the renderer, once a frame has set up its camera
+    ControlPoints bezierPatch;
+    for (int i = 0; i < 16; i++)
+        bezierPatch.vertices.push_back(Point3(patch[i][0], patch[i][1], patch[i][2]));
+    RenderParameters renderParameters(&bezierPatch);
+    renderParameters.orthoProjection = false;
+    PatchRenderer renderer(&bezierPatch, &renderParameters);
+    renderer.Resize(WIDTH, HEIGHT);
+    renderer.Render();
+    std::vector<Homogeneous4> worldPoints(4096);
+    for (Homogeneous4 &point : worldPoints)
+        point = Homogeneous4(6.0f * random() - 3.0f, 6.0f * random() - 3.0f, 8.0f * random() - 4.0f, 1.0f);
+    const long nTransforms = 1000000;
+    timeStage("transformPoint()", "points", nTransforms, [&]() {
+        float sum = 0.0f;
+        for (long i = 0; i < nTransforms; i++)
+            sum += renderer.transformPoint(worldPoints[i & 4095]).x;
+        checksum += sum;
+    });
+
+    // keying and sorting a frame's fragments for the Painter's algorithm, about one a pixel
+    const long nFragments = 1000000;
+    std::vector<Point3> fragments(nFragments);
+    for (Point3 &fragment : fragments)
+        fragment = Point3(WIDTH * random(), HEIGHT * random(), 2.0f * random() - 1.0f);
+    FragmentSorter sorter;
+    sorter.Resize(WIDTH, HEIGHT);
+    timeStage("fragment sort", "fragments", nFragments, [&]() {
+        sorter.Reserve(nFragments);
+        #pragma omp parallel for
+        for (long i = 0; i < nFragments; i++) {
+            sorter.keys[i] = sorter.Key(fragments[i]);
+            sorter.payloads[i] = (uint32_t)i;
+        }
+        sorter.Sort();
+        checksum += sorter.payloads[nFragments / 2];
+    });
+
+    // shading the framebuffer from the nearest fragments, as the depth buffer and atomic modes end a frame
+    const long nPixels = (long)WIDTH * HEIGHT;
+    RGBAImage frameBuffer;
+    frameBuffer.Resize(WIDTH, HEIGHT);
+    ShadeBuffer shadeBuffer;
+    shadeBuffer.Resize(WIDTH, HEIGHT);
+    AtomicFrameBuffer atomicFrameBuffer;
+    atomicFrameBuffer.Resize(WIDTH, HEIGHT);
+    atomicFrameBuffer.clear(FragmentShade::Flat(RGBAValue(204.0f, 204.0f, 153.0f, 255.0f)));
+    for (long i = 0; i < nPixels; i++) {
+        FragmentShade shade = i % 5 == 0 ? FragmentShade::Flat(RGBAValue(0.0f, 255.0f, 0.0f, 255.0f)) : FragmentShade::Surface(random(), random());
+        shadeBuffer.block[i] = shade;
+        atomicFrameBuffer.depthTest(Point3((float)(i % WIDTH), (float)(i / WIDTH), 2.0f * random() - 1.0f), shade);
+    }
+    auto shade = [](FragmentShade fragmentShade) { return shadeFragment(fragmentShade); };
+    timeStage("shade buffer resolve", "pixels", nPixels, [&]() {
+        shadeBuffer.resolve(frameBuffer, shade);
+        checksum += frameBuffer.block[nPixels / 2].red;
+    });
+    timeStage("atomic framebuffer resolve", "pixels", nPixels, [&]() {
+        atomicFrameBuffer.resolve(frameBuffer, shade);
+        checksum += frameBuffer.block[nPixels / 3].red;
+    });
+
+    // clearing the framebuffer, as the Painter's algorithm starts a frame
+    timeStage("RGBAImage::clear", "pixels", nPixels, [&]() {
+        frameBuffer.clear(RGBAValue(204.0f, 204.0f, 153.0f, 255.0f));
+        checksum += frameBuffer.block[nPixels - 1].red;
+    });
+
+    std::cout << "checksum " << checksum << std::endl;
+    return 0;
+}